@@ -0,0 +1,394 @@
+#include "odbcpp.hpp"
+#include "odbcpp_bulk.hpp"
+#include "odbcpp_format.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+// throughput benchmarks: loads synthetic tables of each data type family
+// and scans them back, printing one JSON object per line, e.g.
+//   ./bench "Driver=SQLite3;Database=:memory:" 100000 > bench_output.txt
+
+namespace {
+
+// every allocation is counted, for allocations per row
+std::atomic<std::size_t> allocations(0);
+
+}
+
+// kept out of line, or GCC sees malloc'd memory reach operator delete
+#ifdef __GNUC__
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+BENCH_NOINLINE void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+BENCH_NOINLINE void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+using namespace odbcpp;
+
+using bench_clock = std::chrono::steady_clock;
+
+struct column_spec {
+    const char* sql_type;
+    data_type type;
+    // characters (or bytes) for pointer types
+    std::size_t length;
+};
+
+// columns cycle through the family's specs
+struct family {
+    const char* name;
+    std::vector<column_spec> columns;
+    std::vector<std::size_t> widths;
+    std::size_t max_rows;
+};
+
+const std::size_t row_counts[] = { 1000, 10000, 100000 };
+
+const std::size_t fetch_sizes[] = { 1, 256 };
+
+const int iterations = 3;
+
+std::vector<family> families()
+{
+    return {
+        { "scalar", {
+            { "INTEGER", data_type::integer, 0 },
+            { "BIGINT", data_type::long_integer, 0 },
+            { "DOUBLE", data_type::double_float, 0 }
+        }, { 4, 16 }, 100000 },
+        { "narrow", {
+            { "VARCHAR(32)", data_type::varchar, 32 }
+        }, { 4, 16 }, 100000 },
+        { "wide", {
+            { "NVARCHAR(32)", data_type::wide_varchar, 32 }
+        }, { 4, 16 }, 100000 },
+        { "struct", {
+            { "TIMESTAMP", data_type::timestamp, 0 },
+            { "DATE", data_type::date, 0 }
+        }, { 4, 16 }, 100000 },
+        { "lob", {
+            { "TEXT", data_type::long_varchar, 4096 },
+            { "BLOB", data_type::long_varbinary, 4096 }
+        }, { 1, 4 }, 10000 }
+    };
+}
+
+std::string table_name(const family& f, std::size_t rows, std::size_t width)
+{
+    return std::string("bench_") + f.name + "_" + std::to_string(rows)
+        + "_" + std::to_string(width);
+}
+
+const column_spec& spec_of(const family& f, std::size_t column)
+{
+    return f.columns[column % f.columns.size()];
+}
+
+void execute(connection& conn, const std::string& statement)
+{
+    auto q = conn.make_query();
+    q.execute(statement);
+}
+
+// deterministic, but varied enough to defeat any compression
+void set_value(bulk_writer& w, std::size_t column, const column_spec& spec,
+        std::size_t row, std::vector<unsigned char>& scratch,
+        std::vector<SQLWCHAR>& wide_scratch)
+{
+    const std::size_t seed = row * 31 + column * 7;
+
+    switch (spec.type) {
+        case data_type::integer:
+            w.set<data_type::integer>(column, static_cast<SQLINTEGER>(seed));
+            break;
+
+        case data_type::long_integer:
+            w.set<data_type::long_integer>(column,
+                    static_cast<SQLBIGINT>(seed) * 1000003);
+            break;
+
+        case data_type::double_float:
+            w.set<data_type::double_float>(column, seed * 0.25 + 0.1);
+            break;
+
+        case data_type::timestamp: {
+            SQL_TIMESTAMP_STRUCT ts = {};
+            ts.year = 2000 + seed % 30;
+            ts.month = 1 + seed % 12;
+            ts.day = 1 + seed % 28;
+            ts.hour = seed % 24;
+            ts.minute = seed % 60;
+            ts.second = (seed / 60) % 60;
+            w.set<data_type::timestamp>(column, ts);
+            break;
+        }
+
+        case data_type::date: {
+            SQL_DATE_STRUCT d = {};
+            d.year = 1970 + seed % 50;
+            d.month = 1 + seed % 12;
+            d.day = 1 + seed % 28;
+            w.set<data_type::date>(column, d);
+            break;
+        }
+
+        case data_type::varchar:
+        case data_type::long_varchar:
+        case data_type::long_varbinary: {
+            // between half and all of the column's length
+            std::size_t len = spec.length / 2 + seed % (spec.length / 2 + 1);
+            scratch.resize(len);
+            for (std::size_t i = 0; i < len; ++i)
+                scratch[i] = static_cast<unsigned char>(
+                        'a' + (seed + i * 13) % 26);
+
+            if (spec.type == data_type::varchar)
+                w.set<data_type::varchar>(column, scratch.data(), len);
+            else if (spec.type == data_type::long_varchar)
+                w.set<data_type::long_varchar>(column, scratch.data(), len);
+            else
+                w.set<data_type::long_varbinary>(column, scratch.data(), len);
+            break;
+        }
+
+        case data_type::wide_varchar: {
+            std::size_t len = spec.length / 2 + seed % (spec.length / 2 + 1);
+            wide_scratch.resize(len);
+            // some of it outside ASCII
+            for (std::size_t i = 0; i < len; ++i)
+                wide_scratch[i] = static_cast<SQLWCHAR>(
+                        (i % 4 ? 'a' : 0x3b1) + (seed + i * 13) % 26);
+            w.set<data_type::wide_varchar>(column, wide_scratch.data(), len);
+            break;
+        }
+
+        default:
+            throw std::invalid_argument("No generator for type!");
+    }
+}
+
+// create and fill the table; returns the load time
+bench_clock::duration load(connection& conn, const family& f,
+        std::size_t rows, std::size_t width)
+{
+    const auto table = table_name(f, rows, width);
+
+    try {
+        execute(conn, "DROP TABLE " + table);
+    } catch (const std::runtime_error&) {
+        // it wasn't there
+    }
+
+    std::string create = "CREATE TABLE " + table + " (";
+    std::vector<bulk_column> columns;
+    for (std::size_t c = 0; c < width; ++c) {
+        const auto& spec = spec_of(f, c);
+        auto name = "c" + std::to_string(c);
+        create += (c ? ", " : "") + name + " " + spec.sql_type;
+        columns.push_back({ name, spec.type, spec.length, 0 });
+    }
+    create += ")";
+    execute(conn, create);
+
+    auto start = bench_clock::now();
+
+    auto writer = bulk_writer::for_insert(conn, table, std::move(columns));
+    std::vector<unsigned char> scratch;
+    std::vector<SQLWCHAR> wide_scratch;
+    for (std::size_t r = 0; r < rows; ++r) {
+        for (std::size_t c = 0; c < width; ++c)
+            set_value(writer, c, spec_of(f, c), r, scratch, wide_scratch);
+        writer.end_row();
+    }
+    writer.flush();
+
+    if (!writer.status().failed_rows.empty())
+        throw std::runtime_error(
+                std::string("Unable to load benchmark table!")
+                + " : " + table + " : " + writer.status().errors.front());
+
+    return bench_clock::now() - start;
+}
+
+std::size_t value_bytes(const datum& d)
+{
+    if (!d)
+        return 0;
+
+    if (detail::is_pointer_type(d.type()))
+        return d.length() * detail::char_size(d.type());
+
+    return detail::element_size(d.type());
+}
+
+struct percentiles {
+    std::uint64_t p50, p90, p99, max;
+};
+
+percentiles percentiles_of(std::vector<std::uint64_t>& samples)
+{
+    if (samples.empty())
+        return { 0, 0, 0, 0 };
+
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double p) {
+        return samples[static_cast<std::size_t>(p * (samples.size() - 1))];
+    };
+    return { at(0.5), at(0.9), at(0.99), samples.back() };
+}
+
+std::string json(const percentiles& p)
+{
+    char buf[128];
+    std::snprintf(buf, sizeof(buf),
+            "{\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"max\":%llu}",
+            static_cast<unsigned long long>(p.p50),
+            static_cast<unsigned long long>(p.p90),
+            static_cast<unsigned long long>(p.p99),
+            static_cast<unsigned long long>(p.max));
+    return buf;
+}
+
+std::uint64_t nanoseconds(bench_clock::duration d)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+}
+
+void print_load(const family& f, std::size_t rows, std::size_t width,
+        bench_clock::duration elapsed)
+{
+    double seconds = nanoseconds(elapsed) / 1e9;
+    std::printf("{\"bench\":\"load\",\"family\":\"%s\",\"rows\":%zu,"
+            "\"width\":%zu,\"rows_per_s\":%.1f}\n",
+            f.name, rows, width, seconds > 0 ? rows / seconds : 0.0);
+}
+
+// scan the table iterations times, timing each row's fetch (at() on every
+// field, then advance()) and format (format() on every field) separately
+void scan(connection& conn, const family& f, std::size_t rows,
+        std::size_t width, std::size_t fetch_size)
+{
+    const auto statement = "SELECT * FROM " + table_name(f, rows, width);
+
+    std::vector<std::uint64_t> execute_ns, fetch_ns, format_ns;
+    execute_ns.reserve(iterations);
+    fetch_ns.reserve(rows * iterations);
+    format_ns.reserve(rows * iterations);
+    std::vector<char> text(4096);
+
+    std::size_t rows_read = 0, bytes = 0, allocs = 0;
+    std::uint64_t fetch_total = 0;
+    for (int i = 0; i < iterations; ++i) {
+        auto q = conn.make_query();
+        q.set_fetch_size(fetch_size);
+
+        auto t0 = bench_clock::now();
+        q.execute(statement);
+        execute_ns.push_back(nanoseconds(bench_clock::now() - t0));
+
+        const std::size_t n_fields = q.fields().size();
+        const std::size_t allocs_before = allocations.load();
+        while (q) {
+            auto t1 = bench_clock::now();
+            for (std::size_t c = 0; c < n_fields; ++c)
+                bytes += value_bytes(q.at(c));
+            auto t2 = bench_clock::now();
+
+            for (std::size_t c = 0; c < n_fields; ++c) {
+                const auto& d = q.at(c);
+                std::size_t size = format_size(d);
+                // grows to the widest value once, then stays put
+                if (size > text.size())
+                    text.resize(size);
+                format(text.data(), text.data() + size, d);
+            }
+            auto t3 = bench_clock::now();
+
+            q.advance();
+            auto t4 = bench_clock::now();
+
+            auto fetch = nanoseconds(t2 - t1) + nanoseconds(t4 - t3);
+            fetch_ns.push_back(fetch);
+            fetch_total += fetch;
+            format_ns.push_back(nanoseconds(t3 - t2));
+            ++rows_read;
+        }
+        allocs += allocations.load() - allocs_before;
+    }
+
+    double seconds = fetch_total / 1e9;
+    auto execute_p = percentiles_of(execute_ns);
+    auto fetch_p = percentiles_of(fetch_ns);
+    auto format_p = percentiles_of(format_ns);
+
+    std::printf("{\"bench\":\"scan\",\"family\":\"%s\",\"rows\":%zu,"
+            "\"width\":%zu,\"fetch_size\":%zu,\"iterations\":%d,"
+            "\"rows_per_s\":%.1f,\"mb_per_s\":%.3f,\"allocs_per_row\":%.3f,"
+            "\"execute_ns\":%s,\"fetch_ns\":%s,\"format_ns\":%s}\n",
+            f.name, rows, width, fetch_size, iterations,
+            seconds > 0 ? rows_read / seconds : 0.0,
+            seconds > 0 ? bytes / seconds / 1e6 : 0.0,
+            rows_read ? static_cast<double>(allocs) / rows_read : 0.0,
+            json(execute_p).c_str(), json(fetch_p).c_str(),
+            json(format_p).c_str());
+    std::fflush(stdout);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const char* conn_str = argc > 1 ? argv[1]
+        : "Driver=SQLite3;Database=:memory:";
+    const std::size_t max_rows = argc > 2
+        ? std::strtoul(argv[2], nullptr, 10) : 100000;
+
+    try {
+        connection conn;
+        if (!conn.connect(make_string(conn_str))) {
+            std::fprintf(stderr, "Unable to connect: %s\n", conn_str);
+            return 1;
+        }
+
+        for (const auto& f : families()) {
+            for (auto rows : row_counts) {
+                if (rows > max_rows || rows > f.max_rows)
+                    continue;
+
+                for (auto width : f.widths) {
+                    print_load(f, rows, width, load(conn, f, rows, width));
+                    for (auto fetch_size : fetch_sizes)
+                        scan(conn, f, rows, width, fetch_size);
+                    execute(conn, "DROP TABLE " + table_name(f, rows, width));
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -2,116 +2,1109 @@
 
 #include <utility>
 #include <cassert>
+#include <cstring>
 #include <algorithm>
+#include <thread>
 
 namespace odbcpp {
 
+namespace {
+
+// columns wider than this (per row) are fetched with SQLGetData instead
+const std::size_t max_bound_column_size = 8192;
+
+// SQLGetData buffers start at the column's declared size, within these
+// bounds; past the upper bound the driver tells us the real length
+const std::size_t min_fetch_buffer = 256;
+const std::size_t max_initial_fetch_buffer = 1 << 20;
+
+using detail::char_size;
+using detail::terminator_size;
+
+SQLUINTEGER isolation_flag(isolation_level level)
+{
+    switch (level) {
+        case isolation_level::read_uncommitted:
+            return SQL_TXN_READ_UNCOMMITTED;
+        case isolation_level::read_committed:
+            return SQL_TXN_READ_COMMITTED;
+        case isolation_level::repeatable_read:
+            return SQL_TXN_REPEATABLE_READ;
+        case isolation_level::serializable:
+            return SQL_TXN_SERIALIZABLE;
+    }
+
+    throw std::invalid_argument("Bad isolation level!");
+}
+
+// utf8 leaves room for each character of narrow text to take the
+// four bytes of its longest UTF-8 encoding
+std::size_t bound_element_size(const field& f, bool utf8)
+{
+    if (!detail::is_pointer_type(f.type))
+        return detail::element_size(f.type);
+
+    if (f.column_size == 0)
+        return 0;
+
+    std::size_t unit = char_size(f.type);
+    if (utf8 && detail::odbc_c_tag_from_type(f.type) == SQL_C_CHAR)
+        unit = 4;
+
+    return f.column_size * unit + terminator_size(f.type);
+}
+
+// a wide field fetched as UTF-8 instead: up to three bytes for each
+// UTF-16 unit (a surrogate pair's four bytes take two)
+void fetch_as_utf8(field& f)
+{
+    switch (f.type) {
+        case data_type::wide_character:
+            f.type = data_type::character;
+            break;
+
+        case data_type::wide_varchar:
+            f.type = data_type::varchar;
+            break;
+
+        case data_type::long_wide_varchar:
+            f.type = data_type::long_varchar;
+            break;
+
+        default:
+            return;
+    }
+
+    f.column_size *= 3;
+}
+
+}
+
+namespace detail {
+
+bool statement_cache::take(const string& statement, entry_list& out)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = index_.find(statement);
+    if (it == index_.end()) {
+        ++misses_;
+        return false;
+    }
+
+    ++hits_;
+    out.splice(out.end(), entries_, it->second);
+    index_.erase(it);
+    return true;
+}
+
+void statement_cache::put(cached_statement&& entry) noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (capacity_ == 0)
+        return;
+
+    try {
+        entries_.push_front(std::move(entry));
+    } catch (...) {
+        // the statement is just freed
+        return;
+    }
+
+    try {
+        index_.emplace(entries_.front().statement, entries_.begin());
+    } catch (...) {
+        entries_.pop_front();
+        return;
+    }
+
+    evict(capacity_);
+}
+
+void statement_cache::resize(std::size_t capacity) noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    evict(capacity_);
+}
+
+void statement_cache::evict(std::size_t capacity) noexcept
+{
+    while (entries_.size() > capacity) {
+        auto last = std::prev(entries_.end());
+        auto range = index_.equal_range(last->statement);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == last) {
+                index_.erase(it);
+                break;
+            }
+        }
+        entries_.erase(last);
+    }
+}
+
+cache_stats statement_cache::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cache_stats { hits_, misses_, entries_.size(), capacity_ };
+}
+
+#ifdef ODBCPP_ENABLE_STATS
+
+// a connection's totals, which its queries add to as they finish
+// executions; hooks run outside the lock, so they may read the totals
+class stats_sink {
+    public:
+        stats_sink() : totals_(), hooks_(), mutex_() {}
+
+        void add(const string& statement, const query_stats& stats)
+        {
+            std::shared_ptr<const stats_hooks> hooks;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                totals_ += stats;
+                hooks = hooks_;
+            }
+
+            if (hooks && hooks->finished)
+                hooks->finished(statement, stats);
+        }
+
+        query_stats totals() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return totals_;
+        }
+
+        void reset()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            totals_ = query_stats();
+        }
+
+        void set_hooks(const stats_hooks& hooks)
+        {
+            auto copy = std::make_shared<const stats_hooks>(hooks);
+            std::lock_guard<std::mutex> lock(mutex_);
+            hooks_ = std::move(copy);
+        }
+
+    private:
+        query_stats totals_;
+        std::shared_ptr<const stats_hooks> hooks_;
+        mutable std::mutex mutex_;
+};
+
+void stats_recorder::finish(const string& statement) noexcept
+{
+    if (current_.executions == 0)
+        return;
+
+    try {
+        total_ += current_;
+        if (sink_)
+            sink_->add(statement, current_);
+    } catch (...) {
+        // counters are best effort; a throwing hook is ignored too
+    }
+
+    // the next execution reuses field_bytes' storage
+    auto bytes = std::move(current_.field_bytes);
+    bytes.clear();
+    current_ = query_stats();
+    current_.field_bytes = std::move(bytes);
+    first_row_pending_ = false;
+}
+
+query_stats stats_recorder::snapshot() const
+{
+    query_stats s = total_;
+    s += current_;
+    return s;
+}
+
+#endif
+
+std::vector<field> describe_fields(handle<handle_type::statement>& stmt)
+{
+    static const std::size_t max_len = 256;
+
+    SQLSMALLINT n_fields;
+    auto ret = SQLNumResultCols(stmt, &n_fields);
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Unable to get field count!")
+                + " : " + stmt.error_message());
+
+    std::vector<field> fields;
+    fields.reserve(n_fields);
+
+    SQLCHAR name_buf[max_len];
+    SQLSMALLINT name_len, odbc_type, decimal_digits, nullable;
+    SQLULEN col_size;
+    for (std::size_t i = 1; i <= static_cast<SQLUSMALLINT>(n_fields); ++i) {
+        auto ret = SQLDescribeCol(stmt, i, name_buf, max_len,
+                &name_len, &odbc_type, &col_size, &decimal_digits, &nullable);
+        if (!SQL_SUCCEEDED(ret))
+            throw std::runtime_error(
+                    std::string("Unable to get field metadata!")
+                    + " : " + stmt.error_message());
+
+        fields.push_back({
+                std::string(reinterpret_cast<char*>(&name_buf[0])),
+                type_from_odbc_sql_tag(odbc_type),
+                col_size,
+                static_cast<std::size_t>(decimal_digits),
+                nullable != SQL_NO_NULLS,
+                static_cast<std::size_t>(name_len) > max_len - 1
+        });
+    }
+
+    return fields;
+}
+
+namespace {
+
+// set a numeric record's type, precision and scale on the descriptor
+// held in the statement attribute desc_attr
+void set_numeric_record(handle<handle_type::statement>& stmt,
+        SQLINTEGER desc_attr, std::size_t index, SQLLEN precision,
+        SQLLEN scale, SQLPOINTER bound)
+{
+    SQLHDESC desc = SQL_NULL_HANDLE;
+    auto ret = SQLGetStmtAttr(stmt, desc_attr, &desc, 0, nullptr);
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string(desc_attr == SQL_ATTR_APP_ROW_DESC
+                    ? "Unable to get row descriptor!"
+                    : "Unable to get parameter descriptor!")
+                + " : " + stmt.error_message());
+
+    // the type first, as setting it resets the others
+    SQLSMALLINT record = static_cast<SQLSMALLINT>(index + 1);
+    ret = SQLSetDescField(desc, record, SQL_DESC_TYPE,
+            reinterpret_cast<SQLPOINTER>(static_cast<SQLLEN>(SQL_C_NUMERIC)),
+            0);
+    if (SQL_SUCCEEDED(ret))
+        ret = SQLSetDescField(desc, record, SQL_DESC_PRECISION,
+                reinterpret_cast<SQLPOINTER>(precision), 0);
+    if (SQL_SUCCEEDED(ret))
+        ret = SQLSetDescField(desc, record, SQL_DESC_SCALE,
+                reinterpret_cast<SQLPOINTER>(scale), 0);
+    if (SQL_SUCCEEDED(ret) && bound)
+        ret = SQLSetDescField(desc, record, SQL_DESC_DATA_PTR, bound, 0);
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Unable to set numeric precision!")
+                + " : " + diagnostics(SQL_HANDLE_DESC, desc));
+}
+
+}
+
+void describe_numeric(handle<handle_type::statement>& stmt,
+        std::size_t column, const field& f, SQLPOINTER bound)
+{
+    if (f.column_size == 0)
+        return;
+
+    // SQL_NUMERIC_STRUCT holds up to 38 digits
+    SQLLEN precision = std::min<std::size_t>(f.column_size, 38);
+    SQLLEN scale = std::min<std::size_t>(f.decimal_digits, precision);
+
+    set_numeric_record(stmt, SQL_ATTR_APP_ROW_DESC, column, precision, scale,
+            bound);
+}
+
+void set_block_cursor(handle<handle_type::statement>& stmt,
+        SQLULEN bind_type, SQLULEN& size, SQLULEN* rows_fetched)
+{
+    auto ret = SQLSetStmtAttr(stmt, SQL_ATTR_ROW_BIND_TYPE,
+            reinterpret_cast<SQLPOINTER>(bind_type), 0);
+    if (SQL_SUCCEEDED(ret))
+        ret = SQLSetStmtAttr(stmt, SQL_ATTR_ROW_ARRAY_SIZE,
+                reinterpret_cast<SQLPOINTER>(size), 0);
+    // the driver may substitute a different rowset size
+    if (SQL_SUCCEEDED(ret))
+        ret = SQLGetStmtAttr(stmt, SQL_ATTR_ROW_ARRAY_SIZE,
+                &size, 0, nullptr);
+    if (SQL_SUCCEEDED(ret))
+        ret = SQLSetStmtAttr(stmt, SQL_ATTR_ROWS_FETCHED_PTR,
+                rows_fetched, 0);
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Unable to set block cursor attributes!")
+                + " : " + stmt.error_message());
+}
+
+void describe_numeric_parameter(handle<handle_type::statement>& stmt,
+        std::size_t param, SQLULEN precision, SQLSMALLINT scale,
+        SQLPOINTER bound)
+{
+    if (precision == 0)
+        return;
+
+    set_numeric_record(stmt, SQL_ATTR_APP_PARAM_DESC, param,
+            static_cast<SQLLEN>(precision), scale, bound);
+}
+
+}
+
 detail::handle<detail::handle_type::environment> connection::shared_env_ {};
 
-connection::env_initializer connection::env_init_ {};
+connection::env_initializer connection::env_init_ {};
+
+query_stats& query_stats::operator+=(const query_stats& other)
+{
+    executions += other.executions;
+    execute_ns += other.execute_ns;
+    max_execute_ns = std::max(max_execute_ns, other.max_execute_ns);
+    first_row_ns += other.first_row_ns;
+    fetch_calls += other.fetch_calls;
+    fetch_ns += other.fetch_ns;
+    rows += other.rows;
+    get_data_calls += other.get_data_calls;
+    get_data_ns += other.get_data_ns;
+    reallocations += other.reallocations;
+
+    if (field_bytes.size() < other.field_bytes.size())
+        field_bytes.resize(other.field_bytes.size());
+    for (std::size_t i = 0; i < other.field_bytes.size(); ++i)
+        field_bytes[i] += other.field_bytes[i];
+
+    return *this;
+}
+
+query::~query() noexcept
+{
+    stats_.finish(statement_);
+
+    if (!cache_ || !prepared_ || pending_ != detail::pending_op::none
+            || static_cast<SQLHSTMT>(stmt_) == SQL_NULL_HANDLE)
+        return;
+
+    // the query's buffers go with it, so nothing may stay bound to them
+    SQLFreeStmt(stmt_, SQL_CLOSE);
+    SQLFreeStmt(stmt_, SQL_UNBIND);
+    SQLFreeStmt(stmt_, SQL_RESET_PARAMS);
+    if (block_) {
+        SQLSetStmtAttr(stmt_, SQL_ATTR_ROW_ARRAY_SIZE,
+                reinterpret_cast<SQLPOINTER>(static_cast<SQLULEN>(1)), 0);
+        SQLSetStmtAttr(stmt_, SQL_ATTR_ROWS_FETCHED_PTR, nullptr, 0);
+    }
+    if (async_)
+        SQLSetStmtAttr(stmt_, SQL_ATTR_ASYNC_ENABLE,
+                reinterpret_cast<SQLPOINTER>(SQL_ASYNC_ENABLE_OFF), 0);
+
+    try {
+        // the cache's fields are as described, with wide types intact
+        bool described = described_statement_ == statement_
+            && !wide_as_utf8_;
+        cache_->put(detail::cached_statement {
+                statement_, std::move(stmt_), params_.size(),
+                described ? std::move(fields_) : std::vector<field>(),
+                described });
+    } catch (...) {
+    }
+}
+
+void query::adopt(detail::cached_statement& entry)
+{
+    statement_ = std::move(entry.statement);
+    params_ = std::vector<detail::parameter_binding>(entry.parameter_count);
+    prepared_ = true;
+
+    if (entry.described) {
+        fields_ = std::move(entry.fields);
+        names_.reserve(fields_.size());
+        for (std::size_t i = 0; i < fields_.size(); ++i)
+            names_[fields_[i].name] = i;
+        described_statement_ = statement_;
+        ++generation_;
+
+        // the cached handle was unbound, which cleared the row
+        // descriptor records numeric fields are fetched through
+        for (std::size_t i = 0; i < fields_.size(); ++i)
+            if (fields_[i].type == data_type::numeric)
+                detail::describe_numeric(stmt_, i, fields_[i]);
+    }
+}
+
+void query::execute(const string& statement)
+{
+    start_execute(statement);
+    wait();
+}
+
+void query::start_execute(const string& statement)
+{
+    check_idle();
+
+    ready_ = false;
+
+    SQLFreeStmt(stmt_, SQL_CLOSE);
+    if (prepared_) {
+        SQLFreeStmt(stmt_, SQL_RESET_PARAMS);
+        params_.clear();
+        prepared_ = false;
+    }
+
+    stats_.finish(statement_);
+    statement_ = statement;
+    stats_.execute_started();
+    pending_ = detail::pending_op::execute_direct;
+}
+
+void query::prepare(const string& statement)
+{
+    check_idle();
+
+    ready_ = false;
+    prepared_ = false;
+
+    stats_.finish(statement_);
+
+    SQLFreeStmt(stmt_, SQL_CLOSE);
+    SQLFreeStmt(stmt_, SQL_RESET_PARAMS);
+    params_.clear();
+
+    auto ret = SQLPrepare(stmt_,
+            const_cast<string::value_type*>(statement.c_str()), SQL_NTS);
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Statement preparation failed!")
+                + " : " + stmt_.error_message());
+
+    SQLSMALLINT n_params;
+    ret = SQLNumParams(stmt_, &n_params);
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Unable to get parameter count!")
+                + " : " + stmt_.error_message());
+
+    params_ = std::vector<detail::parameter_binding>(n_params);
+    statement_ = statement;
+    prepared_ = true;
+}
+
+void query::execute()
+{
+    start_execute();
+    wait();
+}
+
+void query::start_execute()
+{
+    check_idle();
+
+    if (!prepared_)
+        throw std::runtime_error("No prepared statement!");
+
+    for (const auto& p : params_)
+        if (!p.bound)
+            throw std::runtime_error("Unbound statement parameter!");
+
+    ready_ = false;
+
+    SQLFreeStmt(stmt_, SQL_CLOSE);
+
+    stats_.finish(statement_);
+    stats_.execute_started();
+    pending_ = detail::pending_op::execute_prepared;
+}
+
+void query::begin_results()
+{
+    if (!fields_current()) {
+        update_fields();
+        bind_block();
+    } else if (block_ ? block_->requested != fetch_size_ : fetch_size_ > 1) {
+        bind_block();
+    }
+
+    // statements without a result set (DML, DDL) have nothing to fetch
+    empty_ = fields_.empty();
+
+    stats_.results(fields_.size());
+
+    data_ = std::vector<std::shared_ptr<datum>>(fields_.size());
+
+    // keep the previous result set's cells (and their buffers)
+    // where the column types line up
+    if (cells_.size() > fields_.size())
+        cells_.erase(cells_.begin() + fields_.size(), cells_.end());
+    for (std::size_t i = 0; i < fields_.size(); ++i) {
+        if (i == cells_.size())
+            cells_.push_back(datum(fields_[i].type));
+        else if (cells_[i].type_ != fields_[i].type)
+            cells_[i] = datum(fields_[i].type);
+    }
+    cell_status_.assign(fields_.size(),
+            detail::cell_status { detail::cell_state::unread, 0 });
+}
+
+void query::bind_impl(std::size_t param, data_type type, const void* value,
+        std::size_t bytes, SQLLEN indicator)
+{
+    if (!prepared_)
+        throw std::runtime_error("No prepared statement!");
+
+    if (param >= params_.size())
+        throw std::runtime_error("Invalid parameter index!");
+
+    auto& p = params_[param];
+
+    // character data gets a null terminator, for the benefit of
+    // drivers which ignore the length indicator
+    std::size_t needed = bytes;
+    if (detail::is_pointer_type(type))
+        needed += terminator_size(type);
+    else
+        needed = detail::element_size(type);
+
+    SQLULEN column_size = 0;
+    SQLSMALLINT decimal_digits = 0;
+    if (detail::is_pointer_type(type)) {
+        // grow in large steps so the declared parameter size (and with
+        // it, the server's plan) changes rarely
+        std::size_t chars = bytes / char_size(type);
+        column_size = p.bound && p.type == type ? p.column_size : 0;
+        if (column_size < chars || column_size == 0)
+            column_size = std::max<std::size_t>(
+                    std::max<std::size_t>(2 * column_size, 64), chars);
+        needed = std::max<std::size_t>(needed,
+                column_size * char_size(type) + terminator_size(type));
+    } else if (type == data_type::timestamp) {
+        // declared with as many fractional digits as the values bound so
+        // far have needed (drivers may reject a fraction which doesn't
+        // fit), growing only so the declaration changes rarely
+        decimal_digits = p.bound && p.type == type ? p.decimal_digits : 0;
+        if (indicator != SQL_NULL_DATA)
+            decimal_digits = std::max(decimal_digits, detail::timestamp_digits(
+                        *static_cast<const SQL_TIMESTAMP_STRUCT*>(value)));
+        column_size = detail::timestamp_column_size(decimal_digits);
+    } else if (type == data_type::numeric && indicator != SQL_NULL_DATA) {
+        const auto* num = static_cast<const SQL_NUMERIC_STRUCT*>(value);
+        column_size = num->precision;
+        decimal_digits = num->scale;
+    }
+
+    bool rebind = !p.bound || p.type != type || p.element_size < needed
+        || p.column_size != column_size || p.decimal_digits != decimal_digits;
+
+    if (p.element_size < needed || !p.values) {
+        p.values.reset(new unsigned char[needed]);
+        p.element_size = needed;
+    }
+
+    if (!p.indicators)
+        p.indicators.reset(new SQLLEN[1]);
+
+    if (value) {
+        const unsigned char* src = static_cast<const unsigned char*>(value);
+        std::copy(src, src + bytes, p.values.get());
+        std::fill(p.values.get() + bytes, p.values.get() + p.element_size, 0);
+    }
+    p.indicators[0] = indicator;
+
+    if (!rebind)
+        return;
+
+    p.bound = false;
+
+    auto ret = SQLBindParameter(stmt_, param + 1, SQL_PARAM_INPUT,
+            detail::odbc_c_tag_from_type(type),
+            detail::odbc_sql_tag_from_type(type),
+            column_size, decimal_digits,
+            p.values.get(), p.element_size, p.indicators.get());
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Unable to bind parameter!")
+                + " : " + stmt_.error_message());
+
+    if (type == data_type::numeric)
+        detail::describe_numeric_parameter(stmt_, param, column_size,
+                decimal_digits, p.values.get());
+
+    p.type = type;
+    p.column_size = column_size;
+    p.decimal_digits = decimal_digits;
+    p.bound = true;
+}
+
+void query::advance()
+{
+    start_advance();
+    wait();
+}
+
+void query::start_advance()
+{
+    check_idle();
+
+    if (!ready_)
+        throw std::runtime_error("No executed statement!");
+
+    // the next row of the block is already here
+    if (block_ && !empty_ && block_->row + 1 < block_->rows_fetched) {
+        ++block_->row;
+        position_block();
+        reset_row();
+        return;
+    }
+
+    pending_ = detail::pending_op::fetch;
+    stats_.fetch_started();
+}
+
+bool query::next_result()
+{
+    start_next_result();
+    wait();
+    return has_result_;
+}
+
+void query::start_next_result()
+{
+    check_idle();
+
+    if (!ready_)
+        throw std::runtime_error("No executed statement!");
+
+    ready_ = false;
+    pending_ = detail::pending_op::next_result;
+}
+
+SQLLEN query::row_count()
+{
+    check_idle();
+
+    if (!ready_)
+        throw std::runtime_error("No executed statement!");
+
+    SQLLEN rows;
+    auto ret = SQLRowCount(stmt_, &rows);
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Unable to get row count!")
+                + " : " + stmt_.error_message());
+
+    return rows;
+}
+
+bool query::poll()
+{
+    using detail::pending_op;
+
+    SQLRETURN ret;
+
+    if (pending_ == pending_op::execute_direct
+            || pending_ == pending_op::execute_prepared
+            || pending_ == pending_op::next_result) {
+        async_mode(true);
+        if (pending_ == pending_op::execute_direct)
+            ret = SQLExecDirect(stmt_, const_cast<string::value_type*>(
+                        statement_.c_str()), SQL_NTS);
+        else if (pending_ == pending_op::execute_prepared)
+            ret = SQLExecute(stmt_);
+        else
+            ret = SQLMoreResults(stmt_);
+
+        if (ret == SQL_STILL_EXECUTING)
+            return false;
+
+        async_mode(false);
+
+        bool next = pending_ == pending_op::next_result;
+        if (!next)
+            stats_.executed();
+
+        if (next && ret == SQL_NO_DATA) {
+            pending_ = pending_op::none;
+            has_result_ = false;
+            empty_ = true;
+            ready_ = true;
+            return true;
+        }
+
+        // SQL_NO_DATA: a searched update or delete which touched no rows
+        if (!SQL_SUCCEEDED(ret) && ret != SQL_NO_DATA) {
+            pending_ = pending_op::none;
+            throw std::runtime_error(
+                    std::string(next ? "Unable to get next result!"
+                        : "Statement execution failed!")
+                    + " : " + stmt_.error_message());
+        }
+
+        has_result_ = true;
+
+        try {
+            // a later result is described afresh, and its fields
+            // don't stand for the statement's (first) result after
+            if (next)
+                described_statement_.clear();
+            begin_results();
+            if (next)
+                described_statement_.clear();
+        } catch (...) {
+            pending_ = pending_op::none;
+            throw;
+        }
+
+        if (empty_) {
+            pending_ = pending_op::none;
+            ready_ = true;
+            return true;
+        }
+
+        pending_ = pending_op::first_fetch;
+        stats_.fetch_started();
+    }
+
+    if (pending_ == pending_op::first_fetch
+            || pending_ == pending_op::fetch) {
+        async_mode(true);
+        ret = SQLFetch(stmt_);
+        if (ret == SQL_STILL_EXECUTING)
+            return false;
+
+        async_mode(false);
+        stats_.fetched(!SQL_SUCCEEDED(ret) ? 0
+                : block_ ? block_->rows_fetched : 1);
+
+        bool first = pending_ == pending_op::first_fetch;
+        pending_ = pending_op::none;
+
+        if (ret == SQL_NO_DATA)
+            empty_ = true;
+        else if (!SQL_SUCCEEDED(ret))
+            throw std::runtime_error(
+                    std::string(first ? "Failed to retrieve first row!"
+                        : "Failed to retrieve next row!")
+                    + " : " + stmt_.error_message());
+
+        if (block_) {
+            block_->row = 0;
+            position_block();
+        }
 
-void query::execute(const string& statement)
+        reset_row();
+        ready_ = true;
+    }
+
+    return true;
+}
+
+void query::wait()
 {
-    ready_ = false;
+    while (!poll())
+        std::this_thread::yield();
+}
 
-    auto ret = SQLExecDirect(stmt_,
-            const_cast<string::value_type*>(statement.c_str()), SQL_NTS);
+void query::check_idle() const
+{
+    if (pending_ != detail::pending_op::none)
+        throw std::runtime_error("Query operation already in progress!");
+}
+
+bool query::set_async(bool enable)
+{
+    check_idle();
+
+    async_ = false;
+    if (!enable)
+        return true;
+
+    // only statement-level async lets each query poll independently
+    SQLUINTEGER mode = SQL_AM_NONE;
+    auto ret = SQLGetInfo(conn_, SQL_ASYNC_MODE, &mode, sizeof(mode), nullptr);
+    if (!SQL_SUCCEEDED(ret) || mode != SQL_AM_STATEMENT)
+        return false;
 
+    ret = SQLSetStmtAttr(stmt_, SQL_ATTR_ASYNC_ENABLE,
+            reinterpret_cast<SQLPOINTER>(SQL_ASYNC_ENABLE_ON), 0);
     if (!SQL_SUCCEEDED(ret))
-        throw std::runtime_error(
-                std::string("Statement execution failed!")
-                + " : " + stmt_.error_message());
+        return false;
 
-    update_fields();
+    async_on_ = true;
+    async_ = true;
+    async_mode(false);
+    return true;
+}
 
-    ret = SQLFetch(stmt_);
-    if (ret == SQL_NO_DATA)
-        empty_ = true;
-    else if (!SQL_SUCCEEDED(ret))
-        throw std::runtime_error(
-                std::string("Failed to retrieve first row!")
-                + " : " + stmt_.error_message());
+// the statement is only asynchronous while executing or fetching,
+// so metadata calls, SQLGetData and the like stay synchronous
+void query::async_mode(bool on)
+{
+    if (!async_ || on == async_on_)
+        return;
 
-    data_ = std::vector<std::shared_ptr<datum>>(fields_.size());
-    ready_ = true;
+    SQLSetStmtAttr(stmt_, SQL_ATTR_ASYNC_ENABLE, reinterpret_cast<SQLPOINTER>(
+                on ? SQL_ASYNC_ENABLE_ON : SQL_ASYNC_ENABLE_OFF), 0);
+    async_on_ = on;
 }
 
-void query::advance()
+void query::reset_row()
 {
-    if (!ready_)
-        throw std::runtime_error("No executed statement!");
+    for (auto& d : data_)
+        d.reset();
 
-    auto ret = SQLFetch(stmt_);
-    if (ret == SQL_NO_DATA)
-        empty_ = true;
-    else if (!SQL_SUCCEEDED(ret))
-        throw std::runtime_error(
-                std::string("Failed to retrieve next row!")
-                + " : " + stmt_.error_message());
+    std::fill(cell_status_.begin(), cell_status_.end(),
+            detail::cell_status { detail::cell_state::unread, 0 });
+}
 
-    data_ = std::vector<std::shared_ptr<datum>>(fields_.size());
+void query::bind_block()
+{
+    if (block_) {
+        SQLFreeStmt(stmt_, SQL_UNBIND);
+        SQLSetStmtAttr(stmt_, SQL_ATTR_ROW_ARRAY_SIZE,
+                reinterpret_cast<SQLPOINTER>(static_cast<SQLULEN>(1)), 0);
+        SQLSetStmtAttr(stmt_, SQL_ATTR_ROWS_FETCHED_PTR, nullptr, 0);
+        block_.reset();
+    }
+
+    for (std::size_t i = 0; i < fields_.size(); ++i)
+        if (fields_[i].type == data_type::numeric)
+            detail::describe_numeric(stmt_, i, fields_[i]);
+
+    if (fetch_size_ <= 1 || fields_.empty())
+        return;
+
+    SQLUINTEGER extensions = 0;
+    auto ret = SQLGetInfo(conn_, SQL_GETDATA_EXTENSIONS,
+            &extensions, sizeof(extensions), nullptr);
+    if (!SQL_SUCCEEDED(ret))
+        extensions = 0;
+
+    // column sizes count characters, not bytes, so multibyte text can
+    // outgrow its buffer; we fetch that again with SQLGetData where the
+    // driver allows it, and otherwise make room for the worst case
+    bool refetch = (extensions & SQL_GD_BOUND) && (extensions & SQL_GD_BLOCK);
+
+    std::vector<std::size_t> sizes;
+    sizes.reserve(fields_.size());
+    bool all_bound = true;
+    for (const auto& f : fields_) {
+        auto size = bound_element_size(f, !refetch);
+        if (size == 0 || size > max_bound_column_size) {
+            size = 0;
+            all_bound = false;
+        }
+        sizes.push_back(size);
+    }
+
+    std::unique_ptr<detail::row_block> block(new detail::row_block());
+    block->requested = fetch_size_;
+    block->size = fetch_size_;
+    block->rows_fetched = 0;
+    block->row = 0;
+    block->positioned = false;
+    block->extensions = extensions;
+
+    if (!all_bound) {
+        // without SQL_GD_ANY_COLUMN, SQLGetData only works on
+        // columns after the last bound column
+        if (!(extensions & SQL_GD_ANY_COLUMN)) {
+            auto first_unbound = std::find(sizes.begin(), sizes.end(), 0);
+            std::fill(first_unbound, sizes.end(), 0);
+        }
+
+        // without SQL_GD_BLOCK, SQLGetData can't be mixed with a
+        // multi-row rowset, so we bind a single row at a time
+        if (extensions & SQL_GD_BLOCK)
+            block->positioned = true;
+        else
+            block->size = 1;
+
+        if (std::count(sizes.begin(), sizes.end(), 0)
+                == static_cast<std::ptrdiff_t>(sizes.size()))
+            return;
+    }
+
+    detail::set_block_cursor(stmt_, SQL_BIND_BY_COLUMN, block->size,
+            &block->rows_fetched);
+
+    if (block->size <= 1)
+        block->positioned = false;
+
+    block->columns.resize(fields_.size());
+    block_ = std::move(block);
+
+    for (std::size_t i = 0; i < fields_.size(); ++i) {
+        if (sizes[i] == 0)
+            continue;
+
+        auto& col = block_->columns[i];
+        col.element_size = sizes[i];
+        col.values.reset(new unsigned char[sizes[i] * block_->size]);
+        col.indicators.reset(new SQLLEN[block_->size]);
+
+        auto ret = SQLBindCol(stmt_, i + 1,
+                detail::odbc_c_tag_from_type(fields_[i].type),
+                col.values.get(), col.element_size, col.indicators.get());
+        if (!SQL_SUCCEEDED(ret))
+            throw std::runtime_error(
+                    std::string("Unable to bind column!")
+                    + " : " + stmt_.error_message());
+
+        if (fields_[i].type == data_type::numeric)
+            detail::describe_numeric(stmt_, i, fields_[i], col.values.get());
+    }
 }
 
-void query::update_fields()
+void query::position_block()
 {
-    static const std::size_t max_len = 256;
+    if (empty_ || !block_->positioned)
+        return;
 
-    SQLSMALLINT n_fields;
-    auto ret = SQLNumResultCols(stmt_, &n_fields);
+    auto ret = SQLSetPos(stmt_, static_cast<SQLSETPOSIROW>(block_->row + 1),
+            SQL_POSITION, SQL_LOCK_NO_CHANGE);
     if (!SQL_SUCCEEDED(ret))
         throw std::runtime_error(
-                std::string("Unable to get field count!")
+                std::string("Unable to position block cursor!")
                 + " : " + stmt_.error_message());
+}
+
+bool query::load_bound(std::size_t field, datum& result)
+{
+    const auto& col = block_->columns[field];
 
-    std::vector<field> new_fields;
-    new_fields.reserve(n_fields);
+    auto indicator = col.indicators[block_->row];
+    if (indicator == SQL_NULL_DATA) {
+        result.null_ = true;
+        return true;
+    }
 
-    std::map<std::string, std::size_t> new_names;
+    unsigned char* value = col.values.get() + block_->row * col.element_size;
 
-    SQLCHAR name_buf[max_len];
-    SQLSMALLINT name_len, odbc_type, decimal_digits, nullable;
-    SQLULEN col_size;
-    for (std::size_t i = 1; i <= static_cast<SQLUSMALLINT>(n_fields); ++i) {
-        auto ret = SQLDescribeCol(stmt_, i, name_buf, max_len,
-                &name_len, &odbc_type, &col_size, &decimal_digits, &nullable);
+    if (!detail::is_pointer_type(result.type_)) {
+        std::memcpy(&result.datum_, value, col.element_size);
+        stats_.read_bytes(field, col.element_size);
+        return true;
+    }
+
+    if (indicator != SQL_NO_TOTAL
+            && static_cast<std::size_t>(indicator)
+               + terminator_size(result.type_) <= col.element_size) {
+        // point straight into the block; copies are made by datum's copy
+        result.assign_pointer(value, indicator / char_size(result.type_));
+        stats_.read_bytes(field, indicator);
+        return true;
+    }
+
+    // the column size counts characters, not bytes (multibyte text in
+    // a narrow column, say), so SQLGetData fetches the whole value
+    bool block = block_->size > 1;
+    if (!(block_->extensions & SQL_GD_BOUND)
+            || (block && !(block_->extensions & SQL_GD_BLOCK)))
+        throw std::runtime_error("Bound column data truncated!");
+
+    if (block && !block_->positioned) {
+        auto ret = SQLSetPos(stmt_,
+                static_cast<SQLSETPOSIROW>(block_->row + 1),
+                SQL_POSITION, SQL_LOCK_NO_CHANGE);
         if (!SQL_SUCCEEDED(ret))
             throw std::runtime_error(
-                    std::string("Unable to get field metadata!")
+                    std::string("Unable to position block cursor!")
                     + " : " + stmt_.error_message());
+    }
 
-        new_fields.push_back({
-                std::string(reinterpret_cast<char*>(&name_buf[0])),
-                detail::type_from_odbc_sql_tag(odbc_type),
-                col_size,
-                static_cast<std::size_t>(decimal_digits),
-                nullable != SQL_NO_NULLS,
-                static_cast<std::size_t>(name_len) > max_len - 1
-        });
+    return false;
+}
 
-        new_names[new_fields.back().name] = i - 1;
-    }
+void query::update_fields()
+{
+    described_statement_.clear();
+
+    auto new_fields = detail::describe_fields(stmt_);
+    if (wide_as_utf8_)
+        for (auto& f : new_fields)
+            fetch_as_utf8(f);
+
+    std::unordered_map<std::string, std::size_t> new_names;
+    new_names.reserve(new_fields.size());
+    for (std::size_t i = 0; i < new_fields.size(); ++i)
+        new_names[new_fields[i].name] = i;
 
     fields_ = std::move(new_fields);
     names_ = std::move(new_names);
+    described_statement_ = statement_;
+    ++generation_;
 }
 
-datum query::get_impl(std::size_t field)
+bool query::fields_current()
 {
-    static const std::size_t buf_chunk = 256;
+    if (described_statement_.empty() || described_statement_ != statement_)
+        return false;
+
+    // the statement's tables may have changed shape since (select *),
+    // which the column count catches in the common cases
+    SQLSMALLINT n_fields;
+    auto ret = SQLNumResultCols(stmt_, &n_fields);
+    return SQL_SUCCEEDED(ret)
+        && static_cast<std::size_t>(n_fields) == fields_.size();
+}
 
+void query::load(std::size_t field, datum& result)
+{
     if (!ready_)
         throw std::runtime_error("No executed statement!");
 
     if (empty_)
         throw std::runtime_error("No data returned!");
 
-    datum result(fields_[field].type);
+    result.null_ = false;
+
+    if (block_ && block_->columns[field].values
+            && load_bound(field, result))
+        return;
 
     SQLLEN result_length;
     if (!detail::is_pointer_type(result.type_)) {
+        auto c_tag = result.type_ == data_type::numeric
+            ? detail::numeric_fetch_tag(fields_[field])
+            : detail::odbc_c_tag_from_type(result.type_);
+        auto start = stats_.now();
         auto ret = SQLGetData(stmt_, field + 1, // odbc uses 1-based indexing for columns
-                detail::odbc_c_tag_from_type(result.type_),
-                &result.datum_, sizeof(result.datum_), &result_length);
+                c_tag, &result.datum_, sizeof(result.datum_), &result_length);
+        stats_.got_data(start);
+        if (!SQL_SUCCEEDED(ret))
+            throw std::runtime_error(
+                    std::string("Unable to retrieve data!")
+                    + " : " + stmt_.error_message());
+
+        if (result_length == SQL_NULL_DATA)
+            result.null_ = true;
+        else
+            stats_.read_bytes(field, detail::element_size(result.type_));
+
+        return;
+    }
+
+    auto c_tag = detail::odbc_c_tag_from_type(result.type_);
+    std::size_t unit = char_size(result.type_);
+    std::size_t terminator = terminator_size(result.type_);
+
+    // the buffer belongs to the column's cell, so it is reused across rows
+    // (and result sets); it starts out big enough for the declared size
+    if (!result.ptr_) {
+        std::size_t initial = min_fetch_buffer;
+        std::size_t hint = fields_[field].column_size;
+        if (hint > 0 && hint <= max_initial_fetch_buffer / unit)
+            initial = std::max(initial, hint * unit + terminator);
+        result.reserve(initial, 0);
+    }
+
+    std::size_t filled = 0;
+    do {
+        // you get back a null terminator for each chunk,
+        // which the next chunk overwrites
+        SQLLEN request_len = result.capacity_ - filled;
+        auto start = stats_.now();
+        auto ret = SQLGetData(stmt_, field + 1, c_tag,
+                static_cast<void*>(result.ptr_.get() + filled),
+                request_len, &result_length);
+        stats_.got_data(start);
         if (!SQL_SUCCEEDED(ret))
             throw std::runtime_error(
                     std::string("Unable to retrieve data!")
@@ -119,70 +1112,206 @@ datum query::get_impl(std::size_t field)
 
         if (result_length == SQL_NULL_DATA) {
             result.null_ = true;
+            return;
         }
 
-        return result;
-    } else {
-        std::size_t next_alloc = buf_chunk, alloc_total = 0;
-        do {
-            std::unique_ptr<unsigned char[]> buf(
-                    new unsigned char[alloc_total + next_alloc]);
-
-            if (result.ptr_)
-                std::copy(result.ptr_.get(), result.ptr_.get() + alloc_total,
-                        buf.get());
-
-            result.ptr_ = std::move(buf);
-
-            // you get back a null terminator for each chunk---
-            unsigned char* this_request_ptr = result.ptr_.get()
-                + (alloc_total ? alloc_total - 1 : 0);
-            SQLLEN this_request_len = next_alloc + (alloc_total ? 1 : 0);
-            alloc_total += next_alloc;
-            // ---which is horrible and stupid
-            auto ret = SQLGetData(stmt_, field + 1,
-                    detail::odbc_c_tag_from_type(result.type_),
-                    static_cast<void*>(this_request_ptr),
-                    this_request_len,
-                    &result_length);
-            if (!SQL_SUCCEEDED(ret))
-                throw std::runtime_error(
-                        std::string("Unable to retrieve data!")
-                        + " : " + stmt_.error_message());
-
-            if (result_length == SQL_NULL_DATA) {
-                result.null_ = true;
-                return result;
-            }
+        if (result_length != SQL_NO_TOTAL
+                && result_length + static_cast<SQLLEN>(terminator)
+                   <= request_len) {
+            filled += result_length;
+            break;
+        }
+
+        // truncated: we got as many whole characters as would fit;
+        // growing geometrically keeps reallocation rare across rows
+        std::size_t needed = result_length == SQL_NO_TOTAL
+            ? 0 : filled + result_length + terminator;
+        filled += (request_len - terminator) / unit * unit;
+        result.reserve(std::max(needed, 2 * result.capacity_), filled);
+        stats_.reallocated();
+    } while (true);
+
+    result.assign_pointer(result.ptr_.get(), filled / unit);
+    stats_.read_bytes(field, filled);
+}
+
+std::size_t query::read(std::size_t field, void* buffer, std::size_t size)
+{
+    if (!ready_)
+        throw std::runtime_error("No executed statement!");
+
+    if (empty_)
+        throw std::runtime_error("No data returned!");
+
+    if (field >= cells_.size())
+        throw std::out_of_range("Invalid field index!");
+
+    auto& cell = cells_[field];
+    if (!detail::is_pointer_type(cell.type_))
+        throw std::runtime_error(
+                "Only character and binary fields can be streamed!");
+
+    auto& status = cell_status_[field];
+    unsigned char* out = static_cast<unsigned char*>(buffer);
+
+    // bound columns are already in memory
+    if (status.state == detail::cell_state::unread
+            && block_ && block_->columns[field].values) {
+        load(field, cell);
+        status.state = detail::cell_state::loaded;
+    }
+
+    if (status.state == detail::cell_state::loaded) {
+        if (!cell)
+            return 0;
 
-            if (result_length == SQL_NO_TOTAL) {
-                next_alloc = buf_chunk;
-            } else if (result_length > this_request_len) {
-                next_alloc = result_length - (this_request_len) + 1;
-            } else {
-                switch (result.type_) {
+        std::size_t bytes = cell.len_ * char_size(cell.type_);
+        std::size_t n = std::min(size, bytes - status.read_offset);
+        const unsigned char* src = cell.raw_pointer() + status.read_offset;
+        std::copy(src, src + n, out);
+        status.read_offset += n;
+        return n;
+    }
+
+    if (status.state == detail::cell_state::exhausted)
+        return 0;
+
+    std::size_t unit = char_size(cell.type_);
+    std::size_t terminator = terminator_size(cell.type_);
+    if (size < unit + terminator)
+        throw std::runtime_error("Buffer too small for streamed read!");
+
+    status.state = detail::cell_state::streaming;
+
+    SQLLEN result_length;
+    auto start = stats_.now();
+    auto ret = SQLGetData(stmt_, field + 1,
+            detail::odbc_c_tag_from_type(cell.type_),
+            buffer, size, &result_length);
+    stats_.got_data(start);
+    if (ret == SQL_NO_DATA) {
+        status.state = detail::cell_state::exhausted;
+        return 0;
+    }
+
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Unable to retrieve data!")
+                + " : " + stmt_.error_message());
+
+    if (result_length == SQL_NULL_DATA) {
+        cell.null_ = true;
+        status.state = detail::cell_state::loaded;
+        return 0;
+    }
+
+    if (result_length != SQL_NO_TOTAL
+            && result_length + static_cast<SQLLEN>(terminator)
+               <= static_cast<SQLLEN>(size)) {
+        status.state = detail::cell_state::exhausted;
+        stats_.read_bytes(field, result_length);
+        return result_length;
+    }
+
+    std::size_t n = (size - terminator) / unit * unit;
+    stats_.read_bytes(field, n);
+    return n;
+}
+
+datum::datum(const datum& other)
+    : type_(other.type_), null_(other.null_), ptr_(nullptr), capacity_(0),
+    len_(other.len_), datum_(other.datum_)
+{
+    if (!null_ && detail::is_pointer_type(type_)) {
+        reserve((len_ + 1) * detail::char_size(type_), 0);
+        const unsigned char* src = other.raw_pointer();
+        std::size_t bytes = len_ * detail::char_size(type_);
+        std::copy(src, src + bytes, ptr_.get());
+        std::fill(ptr_.get() + bytes, ptr_.get() + capacity_, 0);
+        assign_pointer(ptr_.get(), len_);
+    }
+}
+
+datum& datum::operator=(const datum& other)
+{
+    if (this == &other)
+        return *this;
+
+    type_ = other.type_;
+    null_ = other.null_;
+    len_ = other.len_;
+    datum_ = other.datum_;
+
+    // reuses our buffer when it's big enough
+    if (!null_ && detail::is_pointer_type(type_)) {
+        std::size_t bytes = len_ * detail::char_size(type_);
+        reserve(bytes + detail::char_size(type_), 0);
+        const unsigned char* src = other.raw_pointer();
+        std::copy(src, src + bytes, ptr_.get());
+        std::fill(ptr_.get() + bytes,
+                ptr_.get() + bytes + detail::char_size(type_), 0);
+        assign_pointer(ptr_.get(), len_);
+    }
+
+    return *this;
+}
+
+void datum::assign_pointer(unsigned char* p, std::size_t len)
+{
+    switch (type_) {
 #define FOR_EACH_DATA_TYPE(tag, _type, c_tag, sql_tag) \
-                    case data_type::tag : \
-                        result.datum_.tag = \
-                            reinterpret_cast<_type>(result.ptr_.get()); \
-                        result.len_ = \
-                            (result_length \
-                             + this_request_ptr - result.ptr_.get()) \
-                            / sizeof(std::remove_pointer<_type>::type); \
-                        break;
+        case data_type::tag : \
+            datum_.tag = reinterpret_cast<_type>(p); \
+            break;
 #include "pointer_types.def"
 
 #undef FOR_EACH_DATA_TYPE
 
-                    default: throw std::runtime_error("Invalid data type!");
-                }
+        default: throw std::runtime_error("Invalid data type!");
+    }
 
-                return result;
-            }
-        } while (true);
+    len_ = len;
+}
+
+const unsigned char* datum::raw_pointer() const
+{
+    switch (type_) {
+#define FOR_EACH_DATA_TYPE(tag, _type, c_tag, sql_tag) \
+        case data_type::tag : \
+            return reinterpret_cast<const unsigned char*>(datum_.tag);
+#include "pointer_types.def"
+
+#undef FOR_EACH_DATA_TYPE
+
+        default: throw std::runtime_error("Invalid data type!");
     }
+}
+
+void datum::reserve(std::size_t bytes, std::size_t keep)
+{
+    if (ptr_ && capacity_ >= bytes)
+        return;
+
+    std::unique_ptr<unsigned char[]> buf(new unsigned char[bytes]);
+    if (ptr_ && keep)
+        std::copy(ptr_.get(), ptr_.get() + keep, buf.get());
 
-    return result;
+    ptr_ = std::move(buf);
+    capacity_ = bytes;
+}
+
+const std::size_t connection::default_statement_cache_size;
+
+connection::connection()
+    : conn_(shared_env_), connected_(false), in_transaction_(false),
+    cache_(std::make_shared<detail::statement_cache>(
+                default_statement_cache_size)),
+#ifdef ODBCPP_ENABLE_STATS
+    stats_(std::make_shared<detail::stats_sink>())
+#else
+    stats_()
+#endif
+{
 }
 
 bool connection::connect(const string& conn_str, bool prompt)
@@ -198,6 +1327,196 @@ bool connection::connect(const string& conn_str, bool prompt)
     return (connected_ = SQL_SUCCEEDED(ret));
 }
 
+void connection::disconnect() noexcept
+{
+    if (!connected_)
+        return;
+
+    // statements can't outlive the connection
+    if (cache_)
+        cache_->clear();
+
+    // drivers refuse to disconnect with a transaction open
+    if (in_transaction_) {
+        SQLEndTran(SQL_HANDLE_DBC, conn_, SQL_ROLLBACK);
+        SQLSetConnectAttr(conn_, SQL_ATTR_AUTOCOMMIT,
+                reinterpret_cast<SQLPOINTER>(SQL_AUTOCOMMIT_ON),
+                SQL_IS_UINTEGER);
+        in_transaction_ = false;
+    }
+
+    SQLDisconnect(conn_);
+}
+
+query connection::prepare(const string& statement)
+{
+    if (!connected_)
+        throw std::runtime_error("No active connection for query!");
+
+    detail::statement_cache::entry_list taken;
+    if (cache_->take(statement, taken)) {
+        auto& entry = taken.front();
+        query q(std::move(entry.stmt), conn_);
+        q.adopt(entry);
+        q.cache_ = cache_;
+        q.stats_.attach(stats_);
+        return q;
+    }
+
+    query q(conn_);
+    q.prepare(statement);
+    q.cache_ = cache_;
+    q.stats_.attach(stats_);
+    return q;
+}
+
+void connection::set_statement_cache_size(std::size_t size)
+{
+    cache_->resize(size);
+}
+
+cache_stats connection::statement_cache_stats() const
+{
+    return cache_->stats();
+}
+
+void connection::begin()
+{
+    if (!connected_)
+        throw std::runtime_error("No active connection for transaction!");
+
+    if (in_transaction_)
+        throw std::runtime_error("Transaction already in progress!");
+
+    auto ret = SQLSetConnectAttr(conn_, SQL_ATTR_AUTOCOMMIT,
+            reinterpret_cast<SQLPOINTER>(SQL_AUTOCOMMIT_OFF), SQL_IS_UINTEGER);
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Unable to begin transaction!")
+                + " : " + conn_.error_message());
+
+    in_transaction_ = true;
+}
+
+void connection::commit(bool keep_open)
+{
+    end_transaction(SQL_COMMIT, keep_open);
+}
+
+void connection::rollback(bool keep_open)
+{
+    end_transaction(SQL_ROLLBACK, keep_open);
+}
+
+void connection::end_transaction(SQLSMALLINT completion, bool keep_open)
+{
+    if (!in_transaction_)
+        throw std::runtime_error("No transaction in progress!");
+
+    auto ret = SQLEndTran(SQL_HANDLE_DBC, conn_, completion);
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string(completion == SQL_COMMIT
+                    ? "Unable to commit transaction!"
+                    : "Unable to roll back transaction!")
+                + " : " + conn_.error_message());
+
+    if (keep_open)
+        return;
+
+    // the transaction is over even if autocommit can't be restored
+    in_transaction_ = false;
+    ret = SQLSetConnectAttr(conn_, SQL_ATTR_AUTOCOMMIT,
+            reinterpret_cast<SQLPOINTER>(SQL_AUTOCOMMIT_ON), SQL_IS_UINTEGER);
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Unable to restore autocommit!")
+                + " : " + conn_.error_message());
+}
+
+void connection::set_isolation(isolation_level level)
+{
+    if (!connected_)
+        throw std::runtime_error("No active connection!");
+
+    auto flag = isolation_flag(level);
+
+    SQLUINTEGER offered = 0;
+    auto ret = SQLGetInfo(conn_, SQL_TXN_ISOLATION_OPTION,
+            &offered, sizeof(offered), nullptr);
+    if (SQL_SUCCEEDED(ret) && !(offered & flag))
+        throw std::runtime_error("Isolation level not supported!");
+
+    ret = SQLSetConnectAttr(conn_, SQL_ATTR_TXN_ISOLATION,
+            reinterpret_cast<SQLPOINTER>(static_cast<SQLULEN>(flag)),
+            SQL_IS_UINTEGER);
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Unable to set isolation level!")
+                + " : " + conn_.error_message());
+}
+
+isolation_level connection::isolation()
+{
+    if (!connected_)
+        throw std::runtime_error("No active connection!");
+
+    SQLUINTEGER flag = 0;
+    auto ret = SQLGetConnectAttr(conn_, SQL_ATTR_TXN_ISOLATION,
+            &flag, SQL_IS_UINTEGER, nullptr);
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Unable to get isolation level!")
+                + " : " + conn_.error_message());
+
+    switch (flag) {
+        case SQL_TXN_READ_UNCOMMITTED:
+            return isolation_level::read_uncommitted;
+        case SQL_TXN_READ_COMMITTED:
+            return isolation_level::read_committed;
+        case SQL_TXN_REPEATABLE_READ:
+            return isolation_level::repeatable_read;
+        case SQL_TXN_SERIALIZABLE:
+            return isolation_level::serializable;
+        default:
+            throw std::runtime_error("Unknown isolation level!");
+    }
+}
+
+#ifdef ODBCPP_ENABLE_STATS
+
+query_stats connection::stats() const
+{
+    return stats_->totals();
+}
+
+void connection::reset_stats()
+{
+    stats_->reset();
+}
+
+void connection::set_stats_hooks(const stats_hooks& hooks)
+{
+    stats_->set_hooks(hooks);
+}
+
+#else
+
+query_stats connection::stats() const
+{
+    return query_stats();
+}
+
+void connection::reset_stats()
+{
+}
+
+void connection::set_stats_hooks(const stats_hooks&)
+{
+}
+
+#endif
+
 namespace detail {
 
 const char* const handle_traits<handle_type::environment>::alloc_fail_msg =
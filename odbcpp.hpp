@@ -1,13 +1,20 @@
 #ifndef ODBCPP_HPP
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <stdexcept>
 #include <type_traits>
 #include <vector>
-#include <map>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
+#ifdef _WIN32
 #include "windows.h"
+#endif
 #include "sql.h"
 #include "sqlext.h"
 
@@ -57,6 +64,9 @@ struct handle_traits<handle_type::descriptor> {
     static const char* const alloc_fail_msg;
 };
 
+// the diagnostic records of any handle, as one message
+inline std::string diagnostics(SQLSMALLINT handle_tag, SQLHANDLE h) noexcept;
+
 template<handle_type HType>
 class handle {
     public:
@@ -171,9 +181,9 @@ struct data_type_traits<data_type::tag> { \
             std::remove_pointer<odbc_type>::type, \
             unsigned char \
         >::value; \
-    static const bool is_wide_char = std::is_same< \
+    static const bool is_wide_char = is_pointer && std::is_same< \
         std::remove_pointer<odbc_type>::type, \
-        wchar_t>::value; \
+        SQLWCHAR>::value; \
     static const std::size_t size = sizeof(odbc_type); \
     static const SQLSMALLINT odbc_sql_tag = sql_tag; \
     static const SQLSMALLINT odbc_c_tag = c_tag; \
@@ -187,6 +197,9 @@ struct data_type_traits<data_type::tag> { \
 inline data_type type_from_odbc_sql_tag(SQLSMALLINT odbc_sql_tag)
 {
     switch (odbc_sql_tag) {
+        // fetched the same way as numeric
+        case SQL_DECIMAL: return data_type::numeric;
+
 #define FOR_EACH_DATA_TYPE(tag, type, c_tag, sql_tag) \
         case sql_tag : return data_type::tag;
 
@@ -324,6 +337,40 @@ inline std::size_t element_size(data_type type)
     throw std::invalid_argument("Bad type tag!");
 }
 
+// size of one element of a pointer type's buffer
+inline std::size_t char_size(data_type type)
+{
+    return odbc_c_tag_from_type(type) == SQL_C_WCHAR
+        ? sizeof(SQLWCHAR) : sizeof(SQLCHAR);
+}
+
+// size of the null terminator the driver appends to character data
+inline std::size_t terminator_size(data_type type)
+{
+    return odbc_c_tag_from_type(type) == SQL_C_BINARY ? 0 : char_size(type);
+}
+
+// the fractional second digits a timestamp value needs, without
+// trailing zeros: none for whole seconds, up to 9 for nanoseconds
+inline SQLSMALLINT timestamp_digits(const SQL_TIMESTAMP_STRUCT& ts) noexcept
+{
+    SQLUINTEGER fraction = ts.fraction;
+    if (fraction == 0)
+        return 0;
+
+    SQLSMALLINT digits = 9;
+    for (; fraction % 10 == 0; fraction /= 10)
+        --digits;
+    return digits;
+}
+
+// a timestamp parameter's declared size for digits of fraction:
+// yyyy-mm-dd hh:mm:ss, then the point and the digits
+inline SQLULEN timestamp_column_size(SQLSMALLINT digits) noexcept
+{
+    return digits ? 20 + digits : 19;
+}
+
 }
 
 constexpr const char* type_name(data_type type) noexcept
@@ -337,12 +384,71 @@ class query;
 
 class datum;
 
+class row_view;
+
 struct field;
 
+class field_ref;
+
+namespace detail {
+
+class statement_cache;
+
+class stats_sink;
+
+}
+
+struct cache_stats {
+    std::size_t hits;
+    std::size_t misses;
+    // handles currently cached
+    std::size_t size;
+    std::size_t capacity;
+};
+
+// performance counters, collected when the library (and everything
+// including it) is built with ODBCPP_ENABLE_STATS; otherwise they
+// compile away, and always read as zero
+// times are in nanoseconds; everything is summed over executions
+struct query_stats {
+    std::uint64_t executions;
+    std::uint64_t execute_ns;
+    std::uint64_t max_execute_ns;
+    // from the start of execution to the first fetch's return
+    std::uint64_t first_row_ns;
+    std::uint64_t fetch_calls;
+    std::uint64_t fetch_ns;
+    std::uint64_t rows;
+    std::uint64_t get_data_calls;
+    std::uint64_t get_data_ns;
+    // growth of SQLGetData buffers
+    std::uint64_t reallocations;
+    // bytes read from the driver, by field index
+    std::vector<std::uint64_t> field_bytes;
+
+    query_stats& operator+=(const query_stats& other);
+};
+
+struct stats_hooks {
+    // called with each execution's counters once its results are
+    // finished with (at the next execute, or the query's destruction),
+    // on the query's thread
+    std::function<void(const string& statement, const query_stats& stats)>
+        finished;
+};
+
+enum class isolation_level : char {
+    read_uncommitted,
+    read_committed,
+    repeatable_read,
+    serializable
+};
+
 class connection {
     public:
-        connection()
-            : conn_(shared_env_), connected_(false) {}
+        static const std::size_t default_statement_cache_size = 16;
+
+        connection();
 
         connection(const string& conn_str)
             : connection() { connect(conn_str); }
@@ -363,16 +469,60 @@ class connection {
 
         bool connect(const string& conn_str, bool prompt=false);
 
-        void disconnect() noexcept
-        {
-            if (connected_)
-                SQLDisconnect(conn_);
-        }
+        // frees the cached statements first, and rolls back any open
+        // transaction
+        void disconnect() noexcept;
 
         explicit operator bool() const noexcept { return connected_; }
 
+        // cheap liveness check (SQL_ATTR_CONNECTION_DEAD), without a
+        // round trip to the server; drivers which don't report the
+        // attribute are assumed alive
+        bool alive() noexcept;
+
         query make_query();
 
+        // a query with statement prepared on it; a statement prepared
+        // before comes back on the same handle, without allocating or
+        // preparing again, if the connection kept it (once its query
+        // was destroyed) in the statement cache
+        query prepare(const string& statement);
+
+        template<class StrType>
+        query prepare(const StrType& statement);
+
+        // at most this many idle statements are kept, least recently
+        // used going first; 0 disables the cache
+        void set_statement_cache_size(std::size_t size);
+
+        cache_stats statement_cache_stats() const;
+
+        // the counters of every finished execution on the connection
+        query_stats stats() const;
+
+        void reset_stats();
+
+        void set_stats_hooks(const stats_hooks& hooks);
+
+        // statements commit as they run (autocommit) outside of an
+        // explicit transaction; begin() turns autocommit off until the
+        // transaction ends, with keep_open starting the next one at once
+        // commits and rollbacks may close the connection's open cursors,
+        // depending on the driver (SQL_CURSOR_COMMIT_BEHAVIOR)
+        void begin();
+
+        void commit(bool keep_open = false);
+
+        void rollback(bool keep_open = false);
+
+        bool in_transaction() const noexcept { return in_transaction_; }
+
+        // throws if the driver doesn't offer the level; some drivers
+        // refuse to change it during a transaction
+        void set_isolation(isolation_level level);
+
+        isolation_level isolation();
+
         detail::handle<detail::handle_type::connection>::native_handle
         native_handle() noexcept { return conn_; }
 
@@ -381,6 +531,16 @@ class connection {
 
         bool connected_;
 
+        bool in_transaction_;
+
+        // shared with the queries it lends statements to
+        std::shared_ptr<detail::statement_cache> cache_;
+
+        // null unless built with ODBCPP_ENABLE_STATS
+        std::shared_ptr<detail::stats_sink> stats_;
+
+        void end_transaction(SQLSMALLINT completion, bool keep_open);
+
         static detail::handle<detail::handle_type::environment> shared_env_;
 
         static struct env_initializer {
@@ -399,6 +559,294 @@ struct field {
     bool name_truncated;
 };
 
+// a field name resolved to its index once (query::resolve), for use
+// on every row; stays valid while the query's fields are unchanged
+class field_ref {
+    public:
+        std::size_t index() const noexcept { return index_; }
+
+    private:
+        std::size_t index_;
+        std::size_t generation_;
+
+        field_ref(std::size_t index, std::size_t generation) noexcept
+            : index_(index), generation_(generation) {}
+
+    friend class query;
+};
+
+namespace detail {
+
+struct string_hash {
+    std::size_t operator()(const string& s) const noexcept
+    {
+        // FNV-1a
+        std::uint64_t h = 14695981039346656037ull;
+        for (auto c : s) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return static_cast<std::size_t>(h);
+    }
+};
+
+struct cached_statement {
+    string statement;
+    handle<handle_type::statement> stmt;
+    std::size_t parameter_count;
+    // the result's fields, if they had been described
+    std::vector<field> fields;
+    bool described;
+};
+
+// idle prepared statements of one connection, most recently used first;
+// locked, since queries may be destroyed on any thread
+class statement_cache {
+    public:
+        explicit statement_cache(std::size_t capacity)
+            : capacity_(capacity), hits_(0), misses_(0), entries_(),
+            index_(), mutex_() {}
+
+        using entry_list = std::list<cached_statement>;
+
+        // move a cached statement for statement (if there is one) into
+        // out, without copying or allocating
+        bool take(const string& statement, entry_list& out);
+
+        // keep an idle statement; evicts the least recently used
+        void put(cached_statement&& entry) noexcept;
+
+        void resize(std::size_t capacity) noexcept;
+
+        void clear() noexcept { resize(0); }
+
+        cache_stats stats() const;
+
+    private:
+        std::size_t capacity_;
+        std::size_t hits_;
+        std::size_t misses_;
+        entry_list entries_;
+        std::unordered_multimap<string, entry_list::iterator, string_hash>
+            index_;
+        mutable std::mutex mutex_;
+
+        void evict(std::size_t capacity) noexcept;
+};
+
+// describe the result columns of an executed (or prepared) statement
+std::vector<field> describe_fields(handle<handle_type::statement>& stmt);
+
+// numeric columns are fetched at the field's precision and scale, set
+// on the row descriptor, as drivers otherwise default to their own
+// (often a scale of 0); setting them unbinds a bound column, so its
+// buffer is passed to be bound again
+// fields of unknown precision are left to the driver's defaults
+void describe_numeric(handle<handle_type::statement>& stmt,
+        std::size_t column, const field& f, SQLPOINTER bound = nullptr);
+
+// make the statement a block cursor of size rows, bound by column
+// (SQL_BIND_BY_COLUMN) or by rows of bind_type bytes; size is updated
+// to the rowset size the driver substituted, if it did
+void set_block_cursor(handle<handle_type::statement>& stmt,
+        SQLULEN bind_type, SQLULEN& size, SQLULEN* rows_fetched);
+
+// likewise for a numeric parameter: the driver reads its struct at the
+// parameter descriptor's precision and scale (SQLBindParameter's column
+// size and decimal digits only describe the server-side parameter)
+void describe_numeric_parameter(handle<handle_type::statement>& stmt,
+        std::size_t param, SQLULEN precision, SQLSMALLINT scale,
+        SQLPOINTER bound);
+
+// the C type to fetch a numeric field as, to match describe_numeric
+inline SQLSMALLINT numeric_fetch_tag(const field& f) noexcept
+{
+    return f.column_size ? SQL_ARD_TYPE : SQL_C_NUMERIC;
+}
+
+// column-wise buffers for one column of a block cursor;
+// unbound columns (too large to bind) have no buffers
+struct column_binding {
+    std::unique_ptr<unsigned char[]> values;
+    std::unique_ptr<SQLLEN[]> indicators;
+    std::size_t element_size;
+};
+
+struct row_block {
+    std::vector<column_binding> columns;
+    // the fetch size asked for; the driver may give size instead
+    std::size_t requested;
+    SQLULEN size;
+    SQLULEN rows_fetched;
+    SQLULEN row;
+    // the driver needs SQLSetPos before SQLGetData on unbound columns
+    bool positioned;
+    // the driver's SQL_GETDATA_EXTENSIONS
+    SQLUINTEGER extensions;
+};
+
+enum class cell_state : char {
+    unread,
+    loaded,
+    streaming,
+    exhausted
+};
+
+struct cell_status {
+    cell_state state;
+    // progress of read() through a loaded cell
+    std::size_t read_offset;
+};
+
+// parameter values are copied into buffers owned by the query,
+// so the driver-side binding survives across executions
+struct parameter_binding {
+    data_type type;
+    std::unique_ptr<unsigned char[]> values;
+    std::unique_ptr<SQLLEN[]> indicators;
+    std::size_t element_size;
+    SQLULEN column_size;
+    SQLSMALLINT decimal_digits;
+    bool bound;
+};
+
+// the driver call an execute or advance is waiting on
+enum class pending_op : char {
+    none,
+    execute_direct,
+    execute_prepared,
+    next_result,
+    first_fetch,
+    fetch
+};
+
+#ifdef ODBCPP_ENABLE_STATS
+
+// a query's counters: those of its latest execution, and the
+// sum of those before
+class stats_recorder {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        using time_point = clock::time_point;
+
+        stats_recorder() : sink_(), total_(), current_(), started_(),
+            fetch_started_(), first_row_pending_(false) {}
+
+        static time_point now() noexcept { return clock::now(); }
+
+        void attach(const std::shared_ptr<stats_sink>& sink) { sink_ = sink; }
+
+        void execute_started() noexcept
+        {
+            started_ = now();
+            first_row_pending_ = true;
+        }
+
+        void executed() noexcept
+        {
+            auto ns = since(started_);
+            ++current_.executions;
+            current_.execute_ns += ns;
+            if (ns > current_.max_execute_ns)
+                current_.max_execute_ns = ns;
+        }
+
+        void results(std::size_t n_fields)
+        {
+            if (current_.field_bytes.size() < n_fields)
+                current_.field_bytes.resize(n_fields);
+        }
+
+        void fetch_started() noexcept { fetch_started_ = now(); }
+
+        void fetched(std::size_t rows) noexcept
+        {
+            auto t = now();
+            ++current_.fetch_calls;
+            current_.fetch_ns += between(fetch_started_, t);
+            current_.rows += rows;
+            if (first_row_pending_) {
+                current_.first_row_ns += between(started_, t);
+                first_row_pending_ = false;
+            }
+        }
+
+        void got_data(time_point start) noexcept
+        {
+            ++current_.get_data_calls;
+            current_.get_data_ns += since(start);
+        }
+
+        void read_bytes(std::size_t field, std::size_t bytes) noexcept
+        {
+            if (field < current_.field_bytes.size())
+                current_.field_bytes[field] += bytes;
+        }
+
+        void reallocated() noexcept { ++current_.reallocations; }
+
+        // hand the latest execution to the connection and its hooks
+        void finish(const string& statement) noexcept;
+
+        query_stats snapshot() const;
+
+    private:
+        std::shared_ptr<stats_sink> sink_;
+        query_stats total_;
+        query_stats current_;
+        time_point started_;
+        time_point fetch_started_;
+        bool first_row_pending_;
+
+        static std::uint64_t between(time_point from, time_point to) noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    to - from).count();
+        }
+
+        static std::uint64_t since(time_point from) noexcept
+        {
+            return between(from, now());
+        }
+};
+
+#else
+
+// counters compiled out
+class stats_recorder {
+    public:
+        struct time_point {};
+
+        static time_point now() noexcept { return time_point(); }
+
+        void attach(const std::shared_ptr<stats_sink>&) noexcept {}
+
+        void execute_started() noexcept {}
+
+        void executed() noexcept {}
+
+        void results(std::size_t) noexcept {}
+
+        void fetch_started() noexcept {}
+
+        void fetched(std::size_t) noexcept {}
+
+        void got_data(time_point) noexcept {}
+
+        void read_bytes(std::size_t, std::size_t) noexcept {}
+
+        void reallocated() noexcept {}
+
+        void finish(const string&) noexcept {}
+
+        query_stats snapshot() const { return query_stats(); }
+};
+
+#endif
+
+}
+
 class query {
     public:
         query(const query&) = delete;
@@ -409,14 +857,109 @@ class query {
 
         query& operator=(query&&) = default;
 
-        ~query() noexcept = default;
+        // a statement from connection::prepare goes back to the
+        // connection's cache
+        ~query() noexcept;
 
         explicit operator bool() const { return ready_ && !empty_; }
 
         void execute(const string& statement);
 
+        // prepare a statement once, for repeated execution with
+        // different parameter values bound through bind()
+        void prepare(const string& statement);
+
+        template<class StrType>
+        void prepare(const StrType& statement)
+        {
+            prepare(make_string(statement));
+        }
+
+        // execute the prepared statement with the current parameters
+        void execute();
+
+        std::size_t parameter_count() const noexcept { return params_.size(); }
+
+        // parameters are numbered from 0, like fields;
+        // values are copied, so the arguments need not outlive the call
+        template<data_type Tag>
+        typename std::enable_if<
+            !detail::data_type_traits<Tag>::is_pointer
+        >::type
+        bind(std::size_t param,
+                const typename detail::data_type_traits<Tag>::odbc_type& value)
+        {
+            bind_impl(param, Tag, &value, sizeof(value), sizeof(value));
+        }
+
+        // length is in characters (or bytes, for binary types)
+        template<data_type Tag>
+        typename std::enable_if<
+            detail::data_type_traits<Tag>::is_pointer
+        >::type
+        bind(std::size_t param,
+                const typename std::remove_pointer<
+                    typename detail::data_type_traits<Tag>::odbc_type
+                >::type* value,
+                std::size_t length)
+        {
+            bind_impl(param, Tag, value, length * sizeof(*value),
+                    length * sizeof(*value));
+        }
+
+        void bind(std::size_t param, const std::string& value)
+        {
+            bind<data_type::varchar>(param,
+                    reinterpret_cast<const SQLCHAR*>(value.data()),
+                    value.size());
+        }
+
+        void bind(std::size_t param, const string& value)
+        {
+            bind<data_type::varchar>(param, value.data(), value.size());
+        }
+
+        void bind_null(std::size_t param, data_type type)
+        {
+            bind_impl(param, type, nullptr, 0, SQL_NULL_DATA);
+        }
+
         void advance();
 
+        // move on to the statement's next result (of a batch, or a
+        // procedure returning several), discarding what remains of this
+        // one; returns false, leaving the query empty, if there is none
+        bool next_result();
+
+        // rows affected by the current result, for INSERT, UPDATE and
+        // DELETE (-1 where the driver can't tell)
+        SQLLEN row_count();
+
+        // fetch rows from the driver in blocks of this many rows,
+        // binding every column small enough to bind;
+        // takes effect at the next execute (1 disables block fetching)
+        void set_fetch_size(std::size_t rows)
+        {
+            fetch_size_ = rows ? rows : 1;
+        }
+
+        std::size_t fetch_size() const noexcept { return fetch_size_; }
+
+        // fetch wide character fields as narrow (SQL_C_CHAR), which the
+        // driver converts to its narrow character set: UTF-8 for most
+        // drivers on Linux and macOS (on Windows, only under a UTF-8
+        // code page), at half the bytes for mostly-ASCII text
+        // such fields report narrow types, with column_size in bytes;
+        // takes effect at the next execute
+        void set_wide_as_utf8(bool enable)
+        {
+            if (enable != wide_as_utf8_)
+                described_statement_.clear();
+            wide_as_utf8_ = enable;
+        }
+
+        bool wide_as_utf8() const noexcept { return wide_as_utf8_; }
+
         // some DBMS require sequential access to fields
         // this function will preload all fields in sequential order
         // enabling subsequent random access
@@ -434,36 +977,192 @@ class query {
 
         const std::vector<field>& fields() const;
 
+        // a copy of the field's value, which outlives the row
         std::shared_ptr<datum> get(std::size_t field);
 
         std::shared_ptr<datum> get(const std::string& field)
         {
-            return get(names_.at(field));
+            return get(field_index(field));
         }
 
+        std::shared_ptr<datum> get(const field_ref& field)
+        {
+            return get(field_index(field));
+        }
+
+        // the field's value in storage the query reuses from row to row,
+        // without allocating; valid until the next advance() or execute
+        const datum& at(std::size_t field);
+
+        const datum& at(const std::string& field)
+        {
+            return at(field_index(field));
+        }
+
+        const datum& at(const field_ref& field)
+        {
+            return at(field_index(field));
+        }
+
+        std::size_t field_index(const std::string& name) const;
+
+        std::size_t field_index(const field_ref& field) const
+        {
+            if (field.generation_ != generation_)
+                throw std::runtime_error("Stale field reference!");
+            return field.index_;
+        }
+
+        // look a name up once, rather than on every row
+        field_ref resolve(const std::string& name) const
+        {
+            return field_ref(field_index(name), generation_);
+        }
+
+        row_view row() noexcept;
+
+        // read the next part of a character or binary field straight
+        // from the driver, without materializing the whole value;
+        // returns the bytes written to buffer (character data comes
+        // without terminators), or 0 once the value is exhausted
+        // a NULL reads as empty, after which at() reports the NULL;
+        // otherwise at() and get() can't be used on a streamed field
+        std::size_t read(std::size_t field, void* buffer, std::size_t size);
+
+        // execute and fetch asynchronously (SQL_ATTR_ASYNC_ENABLE);
+        // returns false, leaving the query synchronous, if the driver
+        // doesn't support statement-level async
+        bool set_async(bool enable);
+
+        bool async() const noexcept { return async_; }
+
+        // begin an execute or advance without waiting for it to finish;
+        // poll() then drives it, returning true (or throwing) once done
+        // in synchronous mode the first poll() does all the work
+        // nothing else may be called on the query in between
+        void start_execute(const string& statement);
+
+        template<class StrType>
+        void start_execute(const StrType& statement)
+        {
+            start_execute(make_string(statement));
+        }
+
+        // start executing the prepared statement
+        void start_execute();
+
+        void start_advance();
+
+        // start moving to the next result; once poll() is done,
+        // has_result() tells whether there was one
+        void start_next_result();
+
+        bool has_result() const noexcept { return has_result_; }
+
+        bool poll();
+
+        bool pending() const noexcept
+        {
+            return pending_ != detail::pending_op::none;
+        }
+
+        // this query's counters, including its latest execution
+        query_stats stats() const { return stats_.snapshot(); }
+
     private:
         detail::handle<detail::handle_type::statement> stmt_;
         std::vector<field> fields_;
         std::vector<std::shared_ptr<datum>> data_;
-        std::map<std::string, std::size_t> names_;
+        std::vector<datum> cells_;
+        std::vector<detail::cell_status> cell_status_;
+        std::unordered_map<std::string, std::size_t> names_;
+        detail::handle<detail::handle_type::connection>::native_handle conn_;
+        std::size_t fetch_size_;
+        std::unique_ptr<detail::row_block> block_;
+        std::vector<detail::parameter_binding> params_;
+        detail::pending_op pending_;
+        // the statement being (or last) prepared or executed
+        string statement_;
+        // the statement fields_ describes; re-executing it reuses them
+        // (and the block cursor's bindings)
+        string described_statement_;
+        // counts changes to fields_, for field_refs
+        std::size_t generation_;
+        bool prepared_;
         bool ready_;
         bool empty_;
+        bool async_;
+        // SQL_ATTR_ASYNC_ENABLE is currently on
+        bool async_on_;
+        // false once next_result() has run out of results
+        bool has_result_;
+        bool wide_as_utf8_;
+
+        // where the statement goes once the query is done with it
+        std::shared_ptr<detail::statement_cache> cache_;
+
+        detail::stats_recorder stats_;
 
         query(detail::handle<detail::handle_type::connection>& conn)
-            : stmt_(conn), fields_(), data_(), names_(),
-            ready_(false), empty_(false) {}
+            : query(detail::handle<detail::handle_type::statement>(conn),
+                    conn) {}
+
+        query(detail::handle<detail::handle_type::statement>&& stmt,
+                detail::handle<detail::handle_type::connection>::native_handle
+                conn)
+            : stmt_(std::move(stmt)), fields_(), data_(), cells_(),
+            cell_status_(), names_(), conn_(conn),
+            fetch_size_(1), block_(), params_(),
+            pending_(detail::pending_op::none), statement_(),
+            described_statement_(), generation_(0),
+            prepared_(false), ready_(false), empty_(false),
+            async_(false), async_on_(false), has_result_(false),
+            wide_as_utf8_(false), cache_(), stats_() {}
+
+        // take over a statement from the cache
+        void adopt(detail::cached_statement& entry);
+
+        void check_idle() const;
+
+        // poll a started operation to completion
+        void wait();
+
+        void async_mode(bool on);
+
+        void begin_results();
+
+        void bind_impl(std::size_t param, data_type type, const void* value,
+                std::size_t bytes, SQLLEN indicator);
 
         void update_fields();
 
-        datum get_impl(std::size_t field);
+        bool fields_current();
+
+        void bind_block();
+
+        void position_block();
+
+        void reset_row();
+
+        void load(std::size_t field, datum& result);
+
+        // false if the value outgrew its buffer, and must be fetched
+        // with SQLGetData instead
+        bool load_bound(std::size_t field, datum& result);
 
         friend query connection::make_query();
+
+        friend query connection::prepare(const string& statement);
 };
 
 class datum {
     public:
+        datum(const datum& other);
+
         datum(datum&&) = default;
 
+        datum& operator=(const datum& other);
+
         datum& operator=(datum&&) = default;
 
         data_type type() const { return type_; }
@@ -501,11 +1200,13 @@ class datum {
 
     private:
         datum(data_type type)
-            : type_(type), null_(false), ptr_(nullptr), len_(0), datum_() {}
+            : type_(type), null_(false), ptr_(nullptr), capacity_(0), len_(0),
+            datum_() {}
 
         data_type type_;
         bool null_;
         std::unique_ptr<unsigned char[]> ptr_;
+        std::size_t capacity_;
         std::size_t len_;
         union odbc_datum {
 #define FOR_EACH_DATA_TYPE(tag, type, c_tag, sql_tag) type tag;
@@ -518,6 +1219,14 @@ class datum {
         typename detail::data_type_traits<Tag>::odbc_type
         get_impl() const noexcept;
 
+        // point the union at p (in ptr_ or elsewhere), holding len elements
+        void assign_pointer(unsigned char* p, std::size_t len);
+
+        const unsigned char* raw_pointer() const;
+
+        // grow ptr_ to at least bytes, keeping the first keep bytes
+        void reserve(std::size_t bytes, std::size_t keep);
+
     friend class query;
 };
 
@@ -537,7 +1246,27 @@ inline query connection::make_query()
 {
     if (!connected_)
         throw std::runtime_error("No active connection for query!");
-    return query(conn_);
+    query q(conn_);
+    q.stats_.attach(stats_);
+    return q;
+}
+
+template<class StrType>
+inline query connection::prepare(const StrType& statement)
+{
+    return prepare(make_string(statement));
+}
+
+inline bool connection::alive() noexcept
+{
+    if (!connected_)
+        return false;
+
+    SQLUINTEGER dead = SQL_CD_FALSE;
+    auto ret = SQLGetConnectAttr(conn_, SQL_ATTR_CONNECTION_DEAD,
+            &dead, 0, nullptr);
+
+    return !SQL_SUCCEEDED(ret) || dead == SQL_CD_FALSE;
 }
 
 inline connection::env_initializer::env_initializer()
@@ -559,14 +1288,71 @@ inline const std::vector<field>& query::fields() const
     return fields_;
 }
 
+inline std::size_t query::field_index(const std::string& name) const
+{
+    auto it = names_.find(name);
+    if (it == names_.end())
+        throw std::out_of_range("Unknown field name!");
+    return it->second;
+}
+
 inline std::shared_ptr<datum> query::get(std::size_t field)
 {
     if (!data_[field])
-        data_[field] = std::make_shared<datum>(get_impl(field));
+        data_[field] = std::make_shared<datum>(at(field));
 
     return std::shared_ptr<datum>(data_[field]);
 }
 
+inline const datum& query::at(std::size_t field)
+{
+    if (field >= cells_.size())
+        throw std::out_of_range("Invalid field index!");
+
+    auto& status = cell_status_[field];
+    if (status.state == detail::cell_state::unread) {
+        load(field, cells_[field]);
+        status.state = detail::cell_state::loaded;
+    } else if (status.state != detail::cell_state::loaded) {
+        throw std::runtime_error("Field has already been streamed!");
+    }
+
+    return cells_[field];
+}
+
+// a non-owning view of a query's current row
+class row_view {
+    public:
+        std::size_t size() const { return q_->fields().size(); }
+
+        const datum& operator[](std::size_t field) const
+        {
+            return q_->at(field);
+        }
+
+        const datum& operator[](const std::string& field) const
+        {
+            return q_->at(field);
+        }
+
+        const datum& operator[](const field_ref& field) const
+        {
+            return q_->at(field);
+        }
+
+    private:
+        query* q_;
+
+        explicit row_view(query* q) noexcept : q_(q) {}
+
+    friend class query;
+};
+
+inline row_view query::row() noexcept
+{
+    return row_view(this);
+}
+
 inline string make_string(const char* str) noexcept
 {
     return string(reinterpret_cast<const string::value_type*>(str));
@@ -581,6 +1367,11 @@ namespace detail {
 
 template<handle_type HType>
 std::string handle<HType>::error_message() noexcept
+{
+    return diagnostics(handle_traits<HType>::native_tag, h_);
+}
+
+inline std::string diagnostics(SQLSMALLINT handle_tag, SQLHANDLE h) noexcept
 {
     static const std::size_t msg_max_len = 256;
 
@@ -593,7 +1384,7 @@ std::string handle<HType>::error_message() noexcept
     while (true) {
         SQLINTEGER native_error;
         SQLSMALLINT ret_len;
-        auto ret = SQLGetDiagRec(handle_traits<HType>::native_tag, h_, rec_no,
+        auto ret = SQLGetDiagRec(handle_tag, h, rec_no,
                 reinterpret_cast<SQLCHAR*>(&code[0]), &native_error,
                 reinterpret_cast<SQLCHAR*>(&msg[0]), msg_max_len, &ret_len);
 
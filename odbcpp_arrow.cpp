@@ -0,0 +1,395 @@
+#include "odbcpp_arrow.hpp"
+#include "odbcpp_numeric.hpp"
+#include "odbcpp_temporal.hpp"
+#include "odbcpp_unicode.hpp"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace odbcpp {
+
+namespace {
+
+struct schema_data {
+    std::string format;
+    std::string name;
+    std::vector<ArrowSchema> children;
+    std::vector<ArrowSchema*> child_ptrs;
+};
+
+struct array_data {
+    std::vector<std::uint8_t> validity;
+    std::vector<unsigned char> values;
+    std::vector<std::int64_t> offsets;
+    const void* buffers[3];
+    std::vector<ArrowArray> children;
+    std::vector<ArrowArray*> child_ptrs;
+};
+
+void release_schema(ArrowSchema* schema)
+{
+    if (!schema->release)
+        return;
+
+    // children the consumer moved elsewhere have been marked released
+    for (int64_t i = 0; i < schema->n_children; ++i)
+        if (schema->children[i]->release)
+            schema->children[i]->release(schema->children[i]);
+
+    delete static_cast<schema_data*>(schema->private_data);
+    schema->release = nullptr;
+}
+
+void release_array(ArrowArray* array)
+{
+    if (!array->release)
+        return;
+
+    for (int64_t i = 0; i < array->n_children; ++i)
+        if (array->children[i]->release)
+            array->children[i]->release(array->children[i]);
+
+    delete static_cast<array_data*>(array->private_data);
+    array->release = nullptr;
+}
+
+void fill_schema(ArrowSchema* out, std::unique_ptr<schema_data> data,
+        int64_t flags)
+{
+    out->format = data->format.c_str();
+    out->name = data->name.c_str();
+    out->metadata = nullptr;
+    out->flags = flags;
+    out->n_children = static_cast<int64_t>(data->child_ptrs.size());
+    out->children = data->child_ptrs.empty() ? nullptr
+        : data->child_ptrs.data();
+    out->dictionary = nullptr;
+    out->release = release_schema;
+    out->private_data = data.release();
+}
+
+// decimal128 is limited to 38 digits
+std::size_t decimal_precision(const field& f)
+{
+    return f.column_size == 0 || f.column_size > 38 ? 38 : f.column_size;
+}
+
+std::string format_for(const field& f)
+{
+    switch (f.type) {
+        case data_type::short_integer: return "s";
+        // SQLINTEGER is 64 bits on some LP64 driver managers
+        case data_type::integer: return sizeof(SQLINTEGER) == 8 ? "l" : "i";
+        case data_type::long_integer: return "l";
+        case data_type::byte: return "c";
+        case data_type::single_float: return "f";
+        case data_type::double_float:
+        case data_type::default_float: return "g";
+        case data_type::bit: return "b";
+        case data_type::date: return "tdD";
+        case data_type::time: return "tts";
+        case data_type::timestamp: return "tsu:";
+        case data_type::interval_year:
+        case data_type::interval_month:
+        case data_type::interval_year_to_month: return "tiM";
+        case data_type::interval_day:
+        case data_type::interval_hour:
+        case data_type::interval_minute:
+        case data_type::interval_second:
+        case data_type::interval_day_to_hour:
+        case data_type::interval_day_to_minute:
+        case data_type::interval_day_to_second:
+        case data_type::interval_hour_to_minute:
+        case data_type::interval_hour_to_second:
+        case data_type::interval_minute_to_second: return "tDu";
+        case data_type::numeric:
+            return "d:" + std::to_string(decimal_precision(f))
+                + "," + std::to_string(f.decimal_digits);
+        case data_type::guid: return "w:16";
+        case data_type::character:
+        case data_type::varchar:
+        case data_type::long_varchar:
+        case data_type::wide_character:
+        case data_type::wide_varchar:
+        case data_type::long_wide_varchar: return "U";
+        case data_type::binary:
+        case data_type::varbinary:
+        case data_type::long_varbinary: return "Z";
+    }
+
+    throw std::invalid_argument("Bad type tag!");
+}
+
+template<class T, class F>
+std::vector<unsigned char> convert(const std::vector<unsigned char>& values,
+        std::size_t n, std::size_t out_size, F fn)
+{
+    std::vector<unsigned char> out(n * out_size);
+    for (std::size_t i = 0; i < n; ++i) {
+        T value;
+        std::memcpy(&value, values.data() + i * sizeof(T), sizeof(T));
+        fn(value, out.data() + i * out_size);
+    }
+
+    return out;
+}
+
+template<class T>
+void store(unsigned char* dst, T value)
+{
+    std::memcpy(dst, &value, sizeof(value));
+}
+
+std::vector<unsigned char> pack_bits(const std::vector<unsigned char>& values,
+        std::size_t n)
+{
+    std::vector<unsigned char> out((n + 7) / 8);
+    for (std::size_t i = 0; i < n; ++i)
+        if (values[i])
+            out[i / 8] |= static_cast<unsigned char>(1u << (i % 8));
+
+    return out;
+}
+
+// wide text as UTF-8, appended to out
+void append_utf8(std::vector<unsigned char>& out, const SQLWCHAR* src,
+        std::size_t len)
+{
+    std::size_t used = out.size();
+    out.resize(used + utf8_capacity(len));
+    char* begin = reinterpret_cast<char*>(out.data()) + used;
+    out.resize(used + (to_utf8(src, len, begin) - begin));
+}
+
+}
+
+namespace detail {
+
+struct arrow_export {
+    static void export_column(column& c, const field& f, ArrowArray* out);
+
+    static void export_result(columnar_result& result, ArrowArray* out);
+};
+
+void arrow_export::export_column(column& c, const field& f, ArrowArray* out)
+{
+    std::unique_ptr<array_data> data(new array_data());
+    const std::size_t n = c.size_;
+    const bool variable = detail::is_pointer_type(c.type_);
+
+    data->validity = std::move(c.validity_);
+
+    switch (c.type_) {
+        case data_type::bit:
+            data->values = pack_bits(c.values_, n);
+            break;
+
+        case data_type::date:
+            data->values = convert<SQL_DATE_STRUCT>(c.values_, n, 4,
+                    [](const SQL_DATE_STRUCT& v, unsigned char* dst) {
+                        store(dst, static_cast<std::int32_t>(
+                                    date_to_days(v)));
+                    });
+            break;
+
+        case data_type::time:
+            data->values = convert<SQL_TIME_STRUCT>(c.values_, n, 4,
+                    [](const SQL_TIME_STRUCT& v, unsigned char* dst) {
+                        store(dst, static_cast<std::int32_t>(
+                                    time_to_seconds(v)));
+                    });
+            break;
+
+        case data_type::timestamp:
+            data->values = convert<SQL_TIMESTAMP_STRUCT>(c.values_, n, 8,
+                    [](const SQL_TIMESTAMP_STRUCT& v, unsigned char* dst) {
+                        store(dst, timestamp_to_micros(v));
+                    });
+            break;
+
+        case data_type::interval_year:
+        case data_type::interval_month:
+        case data_type::interval_year_to_month:
+            data->values = convert<SQL_INTERVAL_STRUCT>(c.values_, n, 4,
+                    [](const SQL_INTERVAL_STRUCT& v, unsigned char* dst) {
+                        store(dst, static_cast<std::int32_t>(
+                                    interval_to_months(v)));
+                    });
+            break;
+
+        case data_type::interval_day:
+        case data_type::interval_hour:
+        case data_type::interval_minute:
+        case data_type::interval_second:
+        case data_type::interval_day_to_hour:
+        case data_type::interval_day_to_minute:
+        case data_type::interval_day_to_second:
+        case data_type::interval_hour_to_minute:
+        case data_type::interval_hour_to_second:
+        case data_type::interval_minute_to_second:
+            data->values = convert<SQL_INTERVAL_STRUCT>(c.values_, n, 8,
+                    [](const SQL_INTERVAL_STRUCT& v, unsigned char* dst) {
+                        store(dst, interval_to_micros(v));
+                    });
+            break;
+
+        case data_type::numeric: {
+            int scale = static_cast<int>(f.decimal_digits);
+            data->values = convert<SQL_NUMERIC_STRUCT>(c.values_, n, 16,
+                    [scale](const SQL_NUMERIC_STRUCT& v, unsigned char* dst) {
+                        numeric_to_decimal128(v, scale, dst);
+                    });
+            break;
+        }
+
+        case data_type::guid:
+            data->values = convert<SQLGUID>(c.values_, n, 16,
+                    [](const SQLGUID& v, unsigned char* dst) {
+                        for (int i = 0; i < 4; ++i)
+                            dst[i] = static_cast<unsigned char>(
+                                    v.Data1 >> (24 - 8 * i));
+                        dst[4] = static_cast<unsigned char>(v.Data2 >> 8);
+                        dst[5] = static_cast<unsigned char>(v.Data2);
+                        dst[6] = static_cast<unsigned char>(v.Data3 >> 8);
+                        dst[7] = static_cast<unsigned char>(v.Data3);
+                        std::memcpy(dst + 8, v.Data4, 8);
+                    });
+            break;
+
+        case data_type::wide_character:
+        case data_type::wide_varchar:
+        case data_type::long_wide_varchar: {
+            const SQLWCHAR* src =
+                reinterpret_cast<const SQLWCHAR*>(c.values_.data());
+            data->values.reserve(c.values_.size() / sizeof(SQLWCHAR));
+            data->offsets.reserve(n + 1);
+            data->offsets.push_back(0);
+            for (std::size_t i = 0; i < n; ++i) {
+                append_utf8(data->values, src + c.offsets_[i],
+                        static_cast<std::size_t>(
+                            c.offsets_[i + 1] - c.offsets_[i]));
+                data->offsets.push_back(
+                        static_cast<std::int64_t>(data->values.size()));
+            }
+            break;
+        }
+
+        default:
+            // the same layout: move, don't copy
+            data->values = std::move(c.values_);
+            if (variable)
+                data->offsets = std::move(c.offsets_);
+    }
+
+    // consumers may expect a data buffer even when it holds nothing
+    if (data->values.empty())
+        data->values.reserve(8);
+
+    data->buffers[0] = c.null_count_ ? data->validity.data() : nullptr;
+    if (variable) {
+        data->buffers[1] = data->offsets.data();
+        data->buffers[2] = data->values.data();
+    } else {
+        data->buffers[1] = data->values.data();
+        data->buffers[2] = nullptr;
+    }
+
+    out->length = static_cast<int64_t>(n);
+    out->null_count = static_cast<int64_t>(c.null_count_);
+    out->offset = 0;
+    out->n_buffers = variable ? 3 : 2;
+    out->n_children = 0;
+    out->buffers = data->buffers;
+    out->children = nullptr;
+    out->dictionary = nullptr;
+    out->release = release_array;
+    out->private_data = data.release();
+
+    c.clear();
+}
+
+void arrow_export::export_result(columnar_result& result, ArrowArray* out)
+{
+    std::unique_ptr<array_data> data(new array_data());
+    const std::size_t n = result.columns_.size();
+
+    data->children.resize(n);
+    for (auto& child : data->children)
+        child.release = nullptr;
+
+    try {
+        for (std::size_t i = 0; i < n; ++i) {
+            export_column(result.columns_[i], result.fields_[i],
+                    &data->children[i]);
+            data->child_ptrs.push_back(&data->children[i]);
+        }
+    } catch (...) {
+        for (auto& child : data->children)
+            release_array(&child);
+        throw;
+    }
+
+    data->buffers[0] = nullptr;
+
+    out->length = static_cast<int64_t>(result.rows_);
+    out->null_count = 0;
+    out->offset = 0;
+    out->n_buffers = 1;
+    out->n_children = static_cast<int64_t>(n);
+    out->buffers = data->buffers;
+    out->children = data->child_ptrs.empty() ? nullptr
+        : data->child_ptrs.data();
+    out->dictionary = nullptr;
+    out->release = release_array;
+    out->private_data = data.release();
+
+    result.clear();
+}
+
+}
+
+void export_arrow_schema(const std::vector<field>& fields, ArrowSchema* out)
+{
+    std::unique_ptr<schema_data> data(new schema_data());
+    data->format = "+s";
+
+    data->children.resize(fields.size());
+    for (auto& child : data->children)
+        child.release = nullptr;
+
+    try {
+        for (std::size_t i = 0; i < fields.size(); ++i) {
+            std::unique_ptr<schema_data> child(new schema_data());
+            child->format = format_for(fields[i]);
+            child->name = fields[i].name;
+            fill_schema(&data->children[i], std::move(child),
+                    fields[i].nullable ? ARROW_FLAG_NULLABLE : 0);
+            data->child_ptrs.push_back(&data->children[i]);
+        }
+    } catch (...) {
+        for (auto& child : data->children)
+            release_schema(&child);
+        throw;
+    }
+
+    fill_schema(out, std::move(data), 0);
+}
+
+void export_arrow_array(columnar_result& result, ArrowArray* out)
+{
+    detail::arrow_export::export_result(result, out);
+}
+
+bool export_arrow_batch(query& q, std::size_t max_rows, ArrowArray* out)
+{
+    if (!q)
+        return false;
+
+    columnar_result batch(q, max_rows);
+    export_arrow_array(batch, out);
+    return true;
+}
+
+}
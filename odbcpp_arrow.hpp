@@ -0,0 +1,86 @@
+#ifndef ODBCPP_ARROW_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "odbcpp.hpp"
+#include "odbcpp_columnar.hpp"
+
+// the Arrow C data interface ABI, as published
+// (https://arrow.apache.org/docs/format/CDataInterface.html)
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    // array type description
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+
+    // release callback
+    void (*release)(struct ArrowSchema*);
+    // opaque producer-specific data
+    void* private_data;
+};
+
+struct ArrowArray {
+    // array data description
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+
+    // release callback
+    void (*release)(struct ArrowArray*);
+    // opaque producer-specific data
+    void* private_data;
+};
+
+#endif
+
+namespace odbcpp {
+
+// results are exported as a struct array ("+s") with one child per field
+// fields map to Arrow types as follows:
+//   short_integer, integer, long_integer, byte    int16, int32, int64, int8
+//   single_float, double_float, default_float     float32, float64
+//   bit                                           boolean
+//   date, time, timestamp       date32, time32[s], timestamp[us] (no zone)
+//   interval_year/_month/_year_to_month           interval[months]
+//   other intervals                               duration[us]
+//   numeric                     decimal128(column_size, decimal_digits)
+//   guid                        fixed_size_binary(16), RFC 4122 byte order
+//   character types             large_utf8 (narrow data is assumed UTF-8;
+//                                 wide data is converted)
+//   binary types                large_binary
+// the consumer calls release() on whatever it receives
+
+// describe fields as the schema of the exported struct array
+void export_arrow_schema(const std::vector<field>& fields, ArrowSchema* out);
+
+// export the result's rows; buffers whose layout Arrow shares (numbers,
+// validity bitmaps, offsets, narrow character and binary data) are moved
+// into the array without copying, the rest are converted
+// the result is left empty, ready to append the next batch
+void export_arrow_array(columnar_result& result, ArrowArray* out);
+
+// drain up to max_rows of the query into out;
+// returns false (leaving out untouched) once no rows remain
+bool export_arrow_batch(query& q, std::size_t max_rows, ArrowArray* out);
+
+}
+
+#define ODBCPP_ARROW_HPP
+#endif
@@ -0,0 +1,164 @@
+#include "odbcpp_async.hpp"
+
+#include <iterator>
+#include <utility>
+
+namespace odbcpp {
+
+async_loop::async_loop(std::size_t threads,
+        std::chrono::microseconds poll_interval)
+    : poll_interval_(poll_interval), workers_(), next_(0), in_flight_(0),
+    stopping_(false)
+{
+    if (threads == 0)
+        threads = 1;
+
+    for (std::size_t i = 0; i < threads; ++i)
+        workers_.emplace_back(new worker());
+
+    for (auto& w : workers_) {
+        worker* p = w.get();
+        p->thread = std::thread([this, p] { run(*p); });
+    }
+}
+
+async_loop::~async_loop() noexcept
+{
+    stopping_ = true;
+
+    for (auto& w : workers_) {
+        {
+            std::lock_guard<std::mutex> lock(w->mutex);
+        }
+        w->wake.notify_one();
+    }
+
+    for (auto& w : workers_)
+        w->thread.join();
+}
+
+std::future<void> async_loop::execute(query& q, const string& statement)
+{
+    callback done;
+    auto result = promise_callback(done);
+    execute(q, statement, std::move(done));
+    return result;
+}
+
+void async_loop::execute(query& q, const string& statement, callback done)
+{
+    q.start_execute(statement);
+    submit(q, std::move(done));
+}
+
+std::future<void> async_loop::execute_prepared(query& q)
+{
+    callback done;
+    auto result = promise_callback(done);
+    execute_prepared(q, std::move(done));
+    return result;
+}
+
+void async_loop::execute_prepared(query& q, callback done)
+{
+    q.start_execute();
+    submit(q, std::move(done));
+}
+
+std::future<void> async_loop::advance(query& q)
+{
+    callback done;
+    auto result = promise_callback(done);
+    advance(q, std::move(done));
+    return result;
+}
+
+void async_loop::advance(query& q, callback done)
+{
+    q.start_advance();
+    submit(q, std::move(done));
+}
+
+std::future<void> async_loop::promise_callback(callback& done)
+{
+    // std::function needs a copyable target
+    auto promise = std::make_shared<std::promise<void>>();
+    done = [promise](std::exception_ptr error) {
+        if (error)
+            promise->set_exception(error);
+        else
+            promise->set_value();
+    };
+
+    return promise->get_future();
+}
+
+void async_loop::submit(query& q, callback done)
+{
+    auto& w = *workers_[next_++ % workers_.size()];
+
+    ++in_flight_;
+    {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.incoming.push_back(operation { &q, std::move(done) });
+    }
+    w.wake.notify_one();
+}
+
+void async_loop::run(worker& w)
+{
+    std::vector<operation> active;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(w.mutex);
+            if (active.empty())
+                w.wake.wait(lock, [this, &w] {
+                    return !w.incoming.empty() || stopping_;
+                });
+
+            if (active.empty() && w.incoming.empty())
+                return;
+
+            std::move(w.incoming.begin(), w.incoming.end(),
+                    std::back_inserter(active));
+            w.incoming.clear();
+        }
+
+        bool progress = false;
+        for (std::size_t i = 0; i < active.size(); ) {
+            std::exception_ptr error;
+            bool complete;
+            try {
+                complete = active[i].q->poll();
+            } catch (...) {
+                complete = true;
+                error = std::current_exception();
+            }
+
+            if (!complete) {
+                ++i;
+                continue;
+            }
+
+            auto done = std::move(active[i].done);
+            if (i + 1 != active.size())
+                active[i] = std::move(active.back());
+            active.pop_back();
+
+            --in_flight_;
+            progress = true;
+
+            try {
+                done(error);
+            } catch (...) {
+            }
+        }
+
+        // everything in flight is still waiting on the server
+        if (!progress && !active.empty())
+            std::this_thread::sleep_for(poll_interval_);
+    }
+}
+
+}
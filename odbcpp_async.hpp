@@ -0,0 +1,100 @@
+#ifndef ODBCPP_ASYNC_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "odbcpp.hpp"
+
+namespace odbcpp {
+
+// drives query operations to completion on a few threads, polling each
+// in-flight query in turn, so many statements can run at once
+// (see query::set_async; queries left synchronous complete on their
+// first poll, occupying a loop thread meanwhile)
+// a submitted query must not be touched until its operation completes,
+// and must outlive it
+class async_loop {
+    public:
+        // called on a loop thread, with the failure if there was one
+        using callback = std::function<void(std::exception_ptr)>;
+
+        explicit async_loop(std::size_t threads = 1,
+                std::chrono::microseconds poll_interval =
+                    std::chrono::microseconds(100));
+
+        async_loop(const async_loop&) = delete;
+
+        async_loop& operator=(const async_loop&) = delete;
+
+        // waits for every submitted operation to complete
+        ~async_loop() noexcept;
+
+        // failures to start an operation are thrown directly;
+        // failures while it runs arrive through the future or callback
+        std::future<void> execute(query& q, const string& statement);
+
+        template<class StrType>
+        std::future<void> execute(query& q, const StrType& statement)
+        {
+            return execute(q, make_string(statement));
+        }
+
+        void execute(query& q, const string& statement, callback done);
+
+        template<class StrType>
+        void execute(query& q, const StrType& statement, callback done)
+        {
+            execute(q, make_string(statement), std::move(done));
+        }
+
+        // execute the query's prepared statement
+        std::future<void> execute_prepared(query& q);
+
+        void execute_prepared(query& q, callback done);
+
+        std::future<void> advance(query& q);
+
+        void advance(query& q, callback done);
+
+        // operations submitted and not yet completed
+        std::size_t in_flight() const noexcept { return in_flight_; }
+
+    private:
+        struct operation {
+            query* q;
+            callback done;
+        };
+
+        struct worker {
+            std::mutex mutex;
+            std::condition_variable wake;
+            std::vector<operation> incoming;
+            std::thread thread;
+        };
+
+        std::chrono::microseconds poll_interval_;
+        std::vector<std::unique_ptr<worker>> workers_;
+        std::atomic<std::size_t> next_;
+        std::atomic<std::size_t> in_flight_;
+        std::atomic<bool> stopping_;
+
+        // a callback which fulfils the returned future
+        static std::future<void> promise_callback(callback& done);
+
+        void submit(query& q, callback done);
+
+        void run(worker& w);
+};
+
+}
+
+#define ODBCPP_ASYNC_HPP
+#endif
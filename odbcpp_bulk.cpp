@@ -0,0 +1,381 @@
+#include "odbcpp_bulk.hpp"
+
+#include <utility>
+#include <algorithm>
+
+namespace odbcpp {
+
+namespace {
+
+// stay under common limits on parameters per statement
+// (e.g. 2100 for SQL Server) in the multi-row VALUES fallback
+const std::size_t max_fallback_params = 2000;
+
+// the indicator of a value not yet set in the current row (no valid
+// input indicator, so one can't be sent by mistake)
+const SQLLEN unset_indicator = SQL_NO_TOTAL;
+
+std::string insert_statement(const std::string& table,
+        const std::vector<bulk_column>& columns, std::size_t rows)
+{
+    std::string stmt = "INSERT INTO " + table + " (";
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+        if (i)
+            stmt += ", ";
+        stmt += columns[i].name;
+    }
+    stmt += ") VALUES ";
+
+    std::string tuple = "(";
+    for (std::size_t i = 0; i < columns.size(); ++i)
+        tuple += i ? ", ?" : "?";
+    tuple += ")";
+
+    for (std::size_t r = 0; r < rows; ++r) {
+        if (r)
+            stmt += ", ";
+        stmt += tuple;
+    }
+
+    return stmt;
+}
+
+}
+
+bulk_writer bulk_writer::for_insert(connection& conn,
+        const std::string& table, std::vector<bulk_column> columns,
+        std::size_t batch_size)
+{
+    auto stmt = insert_statement(table, columns, 1);
+    return bulk_writer(conn, std::move(stmt), table, std::move(columns),
+            batch_size);
+}
+
+bulk_writer bulk_writer::for_statement(connection& conn,
+        const std::string& statement, std::vector<bulk_column> columns,
+        std::size_t batch_size)
+{
+    return bulk_writer(conn, statement, std::string(), std::move(columns),
+            batch_size);
+}
+
+bulk_writer::bulk_writer(connection& conn, std::string statement,
+        std::string table, std::vector<bulk_column> columns,
+        std::size_t batch_size)
+    : stmt_(conn.native_handle()), statement_(std::move(statement)),
+    table_(std::move(table)), columns_(std::move(columns)),
+    params_(columns_.size()), param_status_(), params_processed_(),
+    batch_size_(batch_size ? batch_size : 1), rows_(0), prepared_rows_(0),
+    arrays_(false), status_()
+{
+    if (!conn)
+        throw std::runtime_error("No active connection for bulk writer!");
+
+    if (columns_.empty())
+        throw std::runtime_error("No columns for bulk writer!");
+
+    for (std::size_t i = 0; i < columns_.size(); ++i) {
+        auto type = columns_[i].type;
+        auto& p = params_[i];
+
+        p.type = type;
+        if (detail::is_pointer_type(type)) {
+            p.column_size = std::max<std::size_t>(columns_[i].max_length, 1);
+            p.element_size = p.column_size * detail::char_size(type)
+                + detail::terminator_size(type);
+        } else {
+            // timestamps grow their fractional digits as values need
+            if (type == data_type::timestamp) {
+                p.column_size = detail::timestamp_column_size(0);
+                p.decimal_digits = 0;
+            } else if (type == data_type::numeric) {
+                p.column_size = columns_[i].max_length;
+                p.decimal_digits = columns_[i].decimal_digits;
+            }
+            p.element_size = detail::element_size(type);
+        }
+
+        p.values.reset(new unsigned char[p.element_size * batch_size_]());
+        p.indicators.reset(new SQLLEN[batch_size_]);
+        std::fill(p.indicators.get(), p.indicators.get() + batch_size_,
+                unset_indicator);
+    }
+
+    prepare(statement_);
+    prepared_rows_ = 1;
+    bind_arrays();
+}
+
+bulk_writer::~bulk_writer() noexcept
+{
+    if (static_cast<SQLHSTMT>(stmt_) == SQL_NULL_HANDLE)
+        return;
+
+    try {
+        flush();
+    } catch (...) {
+    }
+}
+
+void bulk_writer::set_impl(std::size_t column, data_type type,
+        const void* value, std::size_t bytes)
+{
+    if (column >= params_.size())
+        throw std::runtime_error("Invalid bulk column index!");
+
+    auto& p = params_[column];
+    if (p.type != type)
+        throw std::runtime_error("Invalid type for bulk column!");
+
+    if (detail::is_pointer_type(type)
+            && bytes + detail::terminator_size(type) > p.element_size)
+        throw std::runtime_error("Value too long for bulk column!");
+
+    unsigned char* dst = p.values.get() + rows_ * p.element_size;
+    const unsigned char* src = static_cast<const unsigned char*>(value);
+    std::copy(src, src + bytes, dst);
+    if (detail::is_pointer_type(type))
+        std::fill(dst + bytes,
+                dst + bytes + detail::terminator_size(type), 0);
+
+    p.indicators[rows_] = bytes;
+
+    if (type == data_type::timestamp) {
+        auto digits = detail::timestamp_digits(
+                *static_cast<const SQL_TIMESTAMP_STRUCT*>(value));
+        if (digits > p.decimal_digits) {
+            p.decimal_digits = digits;
+            p.column_size = detail::timestamp_column_size(digits);
+            p.bound = false;
+        }
+    }
+}
+
+void bulk_writer::set_null(std::size_t column)
+{
+    if (column >= params_.size())
+        throw std::runtime_error("Invalid bulk column index!");
+
+    params_[column].indicators[rows_] = SQL_NULL_DATA;
+}
+
+void bulk_writer::end_row()
+{
+    for (std::size_t i = 0; i < params_.size(); ++i)
+        if (params_[i].indicators[rows_] == unset_indicator)
+            throw std::runtime_error(
+                    std::string("Bulk column not set!")
+                    + " : " + columns_[i].name);
+
+    if (++rows_ == batch_size_)
+        flush();
+}
+
+void bulk_writer::flush()
+{
+    if (rows_ == 0)
+        return;
+
+    if (arrays_)
+        flush_arrays();
+    else
+        flush_fallback();
+
+    // every row of the next batch starts out unset again
+    for (auto& p : params_)
+        std::fill(p.indicators.get(), p.indicators.get() + rows_,
+                unset_indicator);
+
+    status_.rows_sent += rows_;
+    rows_ = 0;
+}
+
+void bulk_writer::prepare(const std::string& statement)
+{
+    SQLFreeStmt(stmt_, SQL_RESET_PARAMS);
+
+    auto sql = make_string(statement);
+    auto ret = SQLPrepare(stmt_, const_cast<SQLCHAR*>(sql.c_str()), SQL_NTS);
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Statement preparation failed!")
+                + " : " + stmt_.error_message());
+}
+
+void bulk_writer::bind_arrays()
+{
+    auto ret = SQLSetStmtAttr(stmt_, SQL_ATTR_PARAM_BIND_TYPE,
+            reinterpret_cast<SQLPOINTER>(SQL_PARAM_BIND_BY_COLUMN), 0);
+    if (SQL_SUCCEEDED(ret))
+        ret = SQLSetStmtAttr(stmt_, SQL_ATTR_PARAMSET_SIZE,
+                reinterpret_cast<SQLPOINTER>(
+                    static_cast<SQLULEN>(batch_size_)), 0);
+
+    // a driver without parameter arrays may refuse the attribute,
+    // or quietly substitute a paramset size of 1
+    SQLULEN paramset_size = 0;
+    if (SQL_SUCCEEDED(ret))
+        ret = SQLGetStmtAttr(stmt_, SQL_ATTR_PARAMSET_SIZE,
+                &paramset_size, 0, nullptr);
+
+    arrays_ = SQL_SUCCEEDED(ret) && paramset_size == batch_size_;
+
+    if (!arrays_) {
+        SQLSetStmtAttr(stmt_, SQL_ATTR_PARAMSET_SIZE,
+                reinterpret_cast<SQLPOINTER>(static_cast<SQLULEN>(1)), 0);
+        return;
+    }
+
+    param_status_.reset(new SQLUSMALLINT[batch_size_]);
+    params_processed_.reset(new SQLULEN(0));
+
+    ret = SQLSetStmtAttr(stmt_, SQL_ATTR_PARAM_STATUS_PTR,
+            param_status_.get(), 0);
+    if (SQL_SUCCEEDED(ret))
+        ret = SQLSetStmtAttr(stmt_, SQL_ATTR_PARAMS_PROCESSED_PTR,
+                params_processed_.get(), 0);
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Unable to set parameter array attributes!")
+                + " : " + stmt_.error_message());
+
+    bind_rows(0, 1);
+}
+
+// bind count consecutive rows, starting from first, as count sets of
+// parameters (a single set covers the whole column with parameter arrays)
+void bulk_writer::bind_rows(std::size_t first, std::size_t count)
+{
+    for (std::size_t r = 0; r < count; ++r) {
+        for (std::size_t i = 0; i < params_.size(); ++i) {
+            auto& p = params_[i];
+            auto ret = SQLBindParameter(stmt_, r * params_.size() + i + 1,
+                    SQL_PARAM_INPUT,
+                    detail::odbc_c_tag_from_type(p.type),
+                    detail::odbc_sql_tag_from_type(p.type),
+                    p.column_size, p.decimal_digits,
+                    p.values.get() + (first + r) * p.element_size,
+                    p.element_size, p.indicators.get() + first + r);
+            if (!SQL_SUCCEEDED(ret))
+                throw std::runtime_error(
+                        std::string("Unable to bind parameter!")
+                        + " : " + stmt_.error_message());
+
+            if (p.type == data_type::numeric)
+                detail::describe_numeric_parameter(stmt_,
+                        r * params_.size() + i, p.column_size,
+                        p.decimal_digits,
+                        p.values.get() + (first + r) * p.element_size);
+        }
+    }
+
+    for (auto& p : params_)
+        p.bound = true;
+}
+
+void bulk_writer::flush_arrays()
+{
+    // a declared size has grown since (a timestamp's digits)
+    if (std::any_of(params_.begin(), params_.end(),
+                [](const detail::parameter_binding& p) { return !p.bound; }))
+        bind_rows(0, 1);
+
+    auto ret = SQLSetStmtAttr(stmt_, SQL_ATTR_PARAMSET_SIZE,
+            reinterpret_cast<SQLPOINTER>(static_cast<SQLULEN>(rows_)), 0);
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Unable to set parameter array size!")
+                + " : " + stmt_.error_message());
+
+    std::fill(param_status_.get(), param_status_.get() + rows_,
+            static_cast<SQLUSMALLINT>(SQL_PARAM_UNUSED));
+    *params_processed_ = 0;
+
+    ret = SQLExecute(stmt_);
+    auto message = ret == SQL_SUCCESS || ret == SQL_NO_DATA ? std::string()
+        : stmt_.error_message();
+
+    // discard any row counts or results the driver queued per row
+    SQLFreeStmt(stmt_, SQL_CLOSE);
+
+    if (ret == SQL_SUCCESS || ret == SQL_NO_DATA)
+        return;
+
+    // a failed execution which processed no rows failed as a whole
+    if (!SQL_SUCCEEDED(ret) && *params_processed_ == 0)
+        throw std::runtime_error(
+                std::string("Bulk statement execution failed!")
+                + " : " + message);
+
+    bool any_failed = false;
+    for (std::size_t r = 0; r < rows_; ++r) {
+        bool failed;
+        switch (param_status_[r]) {
+            case SQL_PARAM_SUCCESS:
+            case SQL_PARAM_SUCCESS_WITH_INFO:
+                failed = false;
+                break;
+
+            // drivers report per-row errors as success with info; rows
+            // they left unused were only skipped if never processed
+            case SQL_PARAM_UNUSED:
+                failed = !SQL_SUCCEEDED(ret) || r >= *params_processed_;
+                break;
+
+            // error, or the batch failed as a unit
+            default:
+                failed = true;
+        }
+
+        if (failed) {
+            status_.failed_rows.push_back(status_.rows_sent + r);
+            any_failed = true;
+        }
+    }
+
+    // warnings alone aren't failures
+    if (SQL_SUCCEEDED(ret) && !any_failed)
+        return;
+
+    if (!any_failed)
+        fail_rows(0, rows_);
+
+    status_.errors.push_back(message);
+}
+
+void bulk_writer::flush_fallback()
+{
+    // one multi-row INSERT per chunk, or one execution per row for
+    // arbitrary statements
+    std::size_t chunk = 1;
+    if (!table_.empty())
+        chunk = std::max<std::size_t>(1, std::min(batch_size_,
+                    max_fallback_params / params_.size()));
+
+    for (std::size_t first = 0; first < rows_; first += chunk) {
+        std::size_t count = std::min(chunk, rows_ - first);
+
+        if (count != prepared_rows_) {
+            prepare(insert_statement(table_, columns_, count));
+            prepared_rows_ = count;
+        }
+
+        bind_rows(first, count);
+
+        auto ret = SQLExecute(stmt_);
+        if (!SQL_SUCCEEDED(ret) && ret != SQL_NO_DATA) {
+            status_.errors.push_back(stmt_.error_message());
+            fail_rows(first, count);
+        }
+
+        SQLFreeStmt(stmt_, SQL_CLOSE);
+    }
+}
+
+void bulk_writer::fail_rows(std::size_t first, std::size_t count)
+{
+    for (std::size_t r = first; r < first + count; ++r)
+        status_.failed_rows.push_back(status_.rows_sent + r);
+}
+
+}
@@ -0,0 +1,150 @@
+#ifndef ODBCPP_BULK_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "odbcpp.hpp"
+
+namespace odbcpp {
+
+struct bulk_column {
+    std::string name;
+    data_type type;
+    // maximum length in characters (or bytes, for binary types),
+    // or precision for numeric; ignored for other fixed-size types
+    std::size_t max_length;
+    // scale for numeric
+    std::size_t decimal_digits;
+};
+
+struct bulk_status {
+    std::size_t rows_sent;
+    // indices (counting from the first row written) of rows which
+    // failed or were not executed because of an earlier failure
+    std::vector<std::size_t> failed_rows;
+    std::vector<std::string> errors;
+};
+
+// writes rows in batches, sending each batch in one execution as an
+// array of parameters (SQL_ATTR_PARAMSET_SIZE)
+// drivers without parameter arrays fall back to multi-row VALUES
+// statements (for inserts) or one execution per row
+class bulk_writer {
+    public:
+        static const std::size_t default_batch_size = 1000;
+
+        // INSERT INTO table (columns...) VALUES (?, ...)
+        // table and column names are used as given
+        static bulk_writer for_insert(connection& conn,
+                const std::string& table,
+                std::vector<bulk_column> columns,
+                std::size_t batch_size = default_batch_size);
+
+        // any DML statement with one parameter per column, in order
+        // (e.g. UPDATE t SET a = ?, b = ? WHERE id = ?)
+        static bulk_writer for_statement(connection& conn,
+                const std::string& statement,
+                std::vector<bulk_column> columns,
+                std::size_t batch_size = default_batch_size);
+
+        bulk_writer(const bulk_writer&) = delete;
+
+        bulk_writer(bulk_writer&&) = default;
+
+        bulk_writer& operator=(const bulk_writer&) = delete;
+
+        bulk_writer& operator=(bulk_writer&&) = default;
+
+        // sends any pending rows; errors are ignored (call flush() first)
+        ~bulk_writer() noexcept;
+
+        template<data_type Tag>
+        typename std::enable_if<
+            !detail::data_type_traits<Tag>::is_pointer
+        >::type
+        set(std::size_t column,
+                const typename detail::data_type_traits<Tag>::odbc_type& value)
+        {
+            set_impl(column, Tag, &value, sizeof(value));
+        }
+
+        // length is in characters (or bytes, for binary types)
+        template<data_type Tag>
+        typename std::enable_if<
+            detail::data_type_traits<Tag>::is_pointer
+        >::type
+        set(std::size_t column,
+                const typename std::remove_pointer<
+                    typename detail::data_type_traits<Tag>::odbc_type
+                >::type* value,
+                std::size_t length)
+        {
+            set_impl(column, Tag, value, length * sizeof(*value));
+        }
+
+        void set(std::size_t column, const std::string& value)
+        {
+            set<data_type::varchar>(column,
+                    reinterpret_cast<const SQLCHAR*>(value.data()),
+                    value.size());
+        }
+
+        void set_null(std::size_t column);
+
+        // finish the current row; sends the batch when it is full
+        // every column must have been set (or set_null) for the row,
+        // or this throws and the row stays open
+        void end_row();
+
+        // send all pending rows
+        void flush();
+
+        std::size_t batch_size() const noexcept { return batch_size_; }
+
+        std::size_t pending_rows() const noexcept { return rows_; }
+
+        // false if the driver doesn't support parameter arrays
+        bool using_arrays() const noexcept { return arrays_; }
+
+        const bulk_status& status() const noexcept { return status_; }
+
+    private:
+        detail::handle<detail::handle_type::statement> stmt_;
+        std::string statement_;
+        std::string table_;
+        std::vector<bulk_column> columns_;
+        std::vector<detail::parameter_binding> params_;
+        std::unique_ptr<SQLUSMALLINT[]> param_status_;
+        std::unique_ptr<SQLULEN> params_processed_;
+        std::size_t batch_size_;
+        std::size_t rows_;
+        // rows per statement in the multi-row VALUES fallback
+        std::size_t prepared_rows_;
+        bool arrays_;
+        bulk_status status_;
+
+        bulk_writer(connection& conn, std::string statement,
+                std::string table, std::vector<bulk_column> columns,
+                std::size_t batch_size);
+
+        void set_impl(std::size_t column, data_type type, const void* value,
+                std::size_t bytes);
+
+        void bind_arrays();
+
+        void bind_rows(std::size_t first, std::size_t count);
+
+        void prepare(const std::string& statement);
+
+        void flush_arrays();
+
+        void flush_fallback();
+
+        void fail_rows(std::size_t first, std::size_t count);
+};
+
+}
+
+#define ODBCPP_BULK_HPP
+#endif
@@ -0,0 +1,116 @@
+#include "odbcpp_columnar.hpp"
+
+#include <cstring>
+
+namespace odbcpp {
+
+column::column(data_type type)
+    : type_(type), size_(0), null_count_(0), validity_(), values_(),
+    offsets_(), append_(nullptr)
+{
+    switch (type) {
+#define FOR_EACH_DATA_TYPE(tag, type, c_tag, sql_tag) \
+        case data_type::tag : \
+            append_ = &column::append_value<data_type::tag>; \
+            break;
+
+#include "nonpointer_types.def"
+#include "pointer_types.def"
+
+#undef FOR_EACH_DATA_TYPE
+    }
+
+    if (detail::is_pointer_type(type))
+        offsets_.push_back(0);
+}
+
+void column::clear() noexcept
+{
+    size_ = 0;
+    null_count_ = 0;
+    validity_.clear();
+    values_.clear();
+    // the buffers may have been moved out (see odbcpp_arrow)
+    if (detail::is_pointer_type(type_))
+        offsets_.assign(1, 0);
+}
+
+template<data_type Tag>
+typename std::enable_if<
+    !detail::data_type_traits<Tag>::is_pointer
+>::type
+column::append_value(column& c, const datum& d)
+{
+    using odbc_type = typename detail::data_type_traits<Tag>::odbc_type;
+
+    std::size_t end = c.values_.size();
+    c.values_.resize(end + sizeof(odbc_type));
+    if (d) {
+        odbc_type value = d.get<Tag>();
+        std::memcpy(c.values_.data() + end, &value, sizeof(value));
+    }
+}
+
+template<data_type Tag>
+typename std::enable_if<
+    detail::data_type_traits<Tag>::is_pointer
+>::type
+column::append_value(column& c, const datum& d)
+{
+    std::size_t len = 0;
+    if (d) {
+        auto value = d.get<Tag>();
+        len = d.length();
+
+        std::size_t bytes = len * sizeof(*value);
+        std::size_t end = c.values_.size();
+        c.values_.resize(end + bytes);
+        std::memcpy(c.values_.data() + end, value, bytes);
+    }
+
+    c.offsets_.push_back(c.offsets_.back() + static_cast<std::int64_t>(len));
+}
+
+columnar_result::columnar_result(query& q, std::size_t max_rows)
+    : fields_(q.fields()), names_(), columns_(), rows_(0)
+{
+    columns_.reserve(fields_.size());
+    for (std::size_t i = 0; i < fields_.size(); ++i) {
+        names_[fields_[i].name] = i;
+        columns_.push_back(column(fields_[i].type));
+    }
+
+    append(q, max_rows);
+}
+
+std::size_t columnar_result::append(query& q, std::size_t max_rows)
+{
+    const auto& fields = q.fields();
+    if (fields.size() != fields_.size())
+        throw std::runtime_error("Result set doesn't match columns!");
+    for (std::size_t i = 0; i < fields.size(); ++i)
+        if (fields[i].type != fields_[i].type)
+            throw std::runtime_error("Result set doesn't match columns!");
+
+    std::size_t n = 0;
+    for (; n < max_rows && q; ++n) {
+        // fields in order, for drivers which require sequential access
+        for (std::size_t i = 0; i < columns_.size(); ++i)
+            columns_[i].append(q.at(i));
+
+        ++rows_;
+        q.advance();
+    }
+
+    return n;
+}
+
+void columnar_result::clear() noexcept
+{
+    for (auto& c : columns_)
+        c.clear();
+
+    rows_ = 0;
+}
+
+}
@@ -0,0 +1,175 @@
+#ifndef ODBCPP_COLUMNAR_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "odbcpp.hpp"
+
+namespace odbcpp {
+
+class columnar_result;
+
+namespace detail {
+
+struct arrow_export;
+
+}
+
+// one column of a columnar_result, in contiguous typed storage
+// buffers follow the Arrow layout: a validity bitmap (bit i, counting
+// from the least significant bit of byte 0, is set if row i is not
+// NULL), fixed-size values in one array, and character or binary
+// values as size() + 1 offsets into one data array
+class column {
+    public:
+        data_type type() const noexcept { return type_; }
+
+        std::size_t size() const noexcept { return size_; }
+
+        std::size_t null_count() const noexcept { return null_count_; }
+
+        const std::uint8_t* validity() const noexcept
+        {
+            return validity_.data();
+        }
+
+        bool is_null(std::size_t row) const noexcept
+        {
+            return !(validity_[row / 8] & (1u << (row % 8)));
+        }
+
+        // fixed-size types: one value per row (zeroed for NULLs)
+        template<data_type Tag>
+        typename std::enable_if<
+            !detail::data_type_traits<Tag>::is_pointer,
+            const typename detail::data_type_traits<Tag>::odbc_type*
+        >::type
+        values() const
+        {
+            check_type(Tag);
+            return reinterpret_cast<
+                const typename detail::data_type_traits<Tag>::odbc_type*>(
+                        values_.data());
+        }
+
+        // character and binary types: row i is elements
+        // [offsets()[i], offsets()[i + 1]) of data(), without terminators
+        // (elements are SQLWCHARs for wide types, bytes otherwise)
+        const std::int64_t* offsets() const noexcept
+        {
+            return offsets_.data();
+        }
+
+        template<data_type Tag>
+        typename std::enable_if<
+            detail::data_type_traits<Tag>::is_pointer,
+            typename detail::data_type_traits<Tag>::odbc_type
+        >::type
+        data() const
+        {
+            check_type(Tag);
+            return reinterpret_cast<
+                typename detail::data_type_traits<Tag>::odbc_type>(
+                        const_cast<unsigned char*>(values_.data()));
+        }
+
+        // the value buffer as raw bytes, for either layout
+        const unsigned char* bytes() const noexcept { return values_.data(); }
+
+        std::size_t byte_size() const noexcept { return values_.size(); }
+
+    private:
+        data_type type_;
+        std::size_t size_;
+        std::size_t null_count_;
+        std::vector<std::uint8_t> validity_;
+        std::vector<unsigned char> values_;
+        std::vector<std::int64_t> offsets_;
+        // chosen once per column, so appending doesn't dispatch per cell
+        void (*append_)(column&, const datum&);
+
+        explicit column(data_type type);
+
+        void check_type(data_type type) const
+        {
+            if (type != type_)
+                throw std::runtime_error("Invalid type for column access.");
+        }
+
+        void append(const datum& d)
+        {
+            std::size_t byte = size_ / 8;
+            if (byte == validity_.size())
+                validity_.push_back(0);
+
+            if (d)
+                validity_[byte] |= static_cast<std::uint8_t>(1u << (size_ % 8));
+            else
+                ++null_count_;
+
+            append_(*this, d);
+            ++size_;
+        }
+
+        void clear() noexcept;
+
+        template<data_type Tag>
+        static typename std::enable_if<
+            !detail::data_type_traits<Tag>::is_pointer
+        >::type
+        append_value(column& c, const datum& d);
+
+        template<data_type Tag>
+        static typename std::enable_if<
+            detail::data_type_traits<Tag>::is_pointer
+        >::type
+        append_value(column& c, const datum& d);
+
+    friend class columnar_result;
+    friend struct detail::arrow_export;
+};
+
+// a result set (or part of one) drained from a query into one
+// column per field
+class columnar_result {
+    public:
+        static const std::size_t all_rows = static_cast<std::size_t>(-1);
+
+        // drain up to max_rows of the query's remaining rows
+        explicit columnar_result(query& q, std::size_t max_rows = all_rows);
+
+        // append up to max_rows more rows from the same result set;
+        // returns the rows appended
+        std::size_t append(query& q, std::size_t max_rows = all_rows);
+
+        // drop the rows, keeping the buffers for the next append
+        void clear() noexcept;
+
+        std::size_t rows() const noexcept { return rows_; }
+
+        const std::vector<field>& fields() const noexcept { return fields_; }
+
+        std::size_t size() const noexcept { return columns_.size(); }
+
+        const column& operator[](std::size_t i) const { return columns_.at(i); }
+
+        const column& operator[](const std::string& name) const
+        {
+            return columns_[names_.at(name)];
+        }
+
+    private:
+        std::vector<field> fields_;
+        std::unordered_map<std::string, std::size_t> names_;
+        std::vector<column> columns_;
+        std::size_t rows_;
+
+    friend struct detail::arrow_export;
+};
+
+}
+
+#define ODBCPP_COLUMNAR_HPP
+#endif
@@ -0,0 +1,232 @@
+#include "odbcpp_csv.hpp"
+#include "odbcpp_format.hpp"
+#include "odbcpp_unicode.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace odbcpp {
+
+csv_writer::csv_writer(int fd, const csv_options& options)
+    : fd_(fd), options_(options), buffer_(), capacity_(0), used_(0),
+    written_(0), header_written_(false), scratch_()
+{
+    capacity_ = std::max<std::size_t>(options_.buffer_size, 4096);
+    buffer_.reset(new char[capacity_]);
+}
+
+csv_writer::~csv_writer() noexcept
+{
+    try {
+        flush();
+    } catch (...) {
+    }
+}
+
+std::size_t csv_writer::write_rows(query& q, std::size_t max_rows)
+{
+    if (options_.header && !header_written_)
+        write_header(q.fields());
+
+    const std::size_t n_fields = q.fields().size();
+
+    std::size_t rows = 0;
+    for (; rows < max_rows && q; ++rows) {
+        for (std::size_t i = 0; i < n_fields; ++i) {
+            if (i) {
+                char* p = reserve(1);
+                *p++ = options_.delimiter;
+                commit(p);
+            }
+
+            write_field(q.at(i));
+        }
+
+        write_raw(options_.line_end.data(), options_.line_end.size());
+        q.advance();
+    }
+
+    return rows;
+}
+
+void csv_writer::write_header(const std::vector<field>& fields)
+{
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+        if (i)
+            write_raw(&options_.delimiter, 1);
+        write_text(fields[i].name.data(), fields[i].name.size());
+    }
+
+    write_raw(options_.line_end.data(), options_.line_end.size());
+    header_written_ = true;
+}
+
+void csv_writer::flush()
+{
+    std::size_t done = 0;
+    while (done < used_) {
+        std::size_t chunk = std::min<std::size_t>(used_ - done, 1 << 30);
+#ifdef _WIN32
+        int n = _write(fd_, buffer_.get() + done,
+                static_cast<unsigned>(chunk));
+#else
+        ssize_t n = ::write(fd_, buffer_.get() + done, chunk);
+#endif
+        if (n < 0) {
+            int error = errno;
+            if (error == EINTR)
+                continue;
+
+            // keep what wasn't written, for another try
+            std::memmove(buffer_.get(), buffer_.get() + done, used_ - done);
+            used_ -= done;
+            written_ += done;
+            throw std::runtime_error(
+                    std::string("Unable to write delimited output!")
+                    + " : " + std::strerror(error));
+        }
+
+        done += static_cast<std::size_t>(n);
+    }
+
+    written_ += used_;
+    used_ = 0;
+}
+
+char* csv_writer::reserve(std::size_t n)
+{
+    if (capacity_ - used_ < n) {
+        flush();
+
+        // a single field bigger than the whole buffer
+        if (capacity_ < n) {
+            buffer_.reset(new char[n]);
+            capacity_ = n;
+        }
+    }
+
+    return buffer_.get() + used_;
+}
+
+void csv_writer::write_raw(const char* s, std::size_t n)
+{
+    char* p = reserve(n);
+    commit(std::copy(s, s + n, p));
+}
+
+void csv_writer::write_text(const char* s, std::size_t n)
+{
+    const char q = options_.quote;
+
+    // a value spelled like the null marker (an empty one, by default)
+    // is quoted, to tell it from a NULL
+    const auto& null = options_.null_marker;
+    bool quote = options_.quote_all
+        || (n == null.size() && std::equal(s, s + n, null.begin()));
+    for (std::size_t i = 0; i < n && !quote; ++i) {
+        char c = s[i];
+        quote = c == options_.delimiter || c == q || c == '\n' || c == '\r';
+    }
+
+    if (!quote) {
+        write_raw(s, n);
+        return;
+    }
+
+    // doubled quotes, at worst
+    char* p = reserve(2 * n + 2);
+    *p++ = q;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (s[i] == q)
+            *p++ = q;
+        *p++ = s[i];
+    }
+    *p++ = q;
+    commit(p);
+}
+
+void csv_writer::write_narrow(const SQLCHAR* s, std::size_t n)
+{
+    write_text(reinterpret_cast<const char*>(s), n);
+}
+
+void csv_writer::write_wide(const SQLWCHAR* s, std::size_t n)
+{
+    scratch_.resize(utf8_capacity(n));
+    char* end = to_utf8(s, n, scratch_.data());
+    write_text(scratch_.data(), end - scratch_.data());
+}
+
+void csv_writer::write_binary(const SQLCHAR* s, std::size_t n)
+{
+    if (options_.binary == binary_encoding::raw) {
+        write_text(reinterpret_cast<const char*>(s), n);
+        return;
+    }
+
+    char* p = reserve(encoded_size(options_.binary, n));
+    commit(encode_binary(options_.binary, s, n, p));
+}
+
+void csv_writer::write_field(const datum& d)
+{
+    if (!d) {
+        write_raw(options_.null_marker.data(), options_.null_marker.size());
+        return;
+    }
+
+    // character data may need quoting; everything else is formatted
+    // (or encoded) straight into the buffer
+    switch (d.type()) {
+        case data_type::character:
+            write_narrow(d.get<data_type::character>(), d.length());
+            return;
+
+        case data_type::varchar:
+            write_narrow(d.get<data_type::varchar>(), d.length());
+            return;
+
+        case data_type::long_varchar:
+            write_narrow(d.get<data_type::long_varchar>(), d.length());
+            return;
+
+        case data_type::wide_character:
+            write_wide(d.get<data_type::wide_character>(), d.length());
+            return;
+
+        case data_type::wide_varchar:
+            write_wide(d.get<data_type::wide_varchar>(), d.length());
+            return;
+
+        case data_type::long_wide_varchar:
+            write_wide(d.get<data_type::long_wide_varchar>(), d.length());
+            return;
+
+        case data_type::binary:
+            write_binary(d.get<data_type::binary>(), d.length());
+            return;
+
+        case data_type::varbinary:
+            write_binary(d.get<data_type::varbinary>(), d.length());
+            return;
+
+        case data_type::long_varbinary:
+            write_binary(d.get<data_type::long_varbinary>(), d.length());
+            return;
+
+        default: {
+            std::size_t size = format_size(d);
+            char* p = reserve(size);
+            commit(format(p, p + size, d));
+        }
+    }
+}
+
+}
@@ -0,0 +1,108 @@
+#ifndef ODBCPP_CSV_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "odbcpp.hpp"
+#include "odbcpp_encoding.hpp"
+
+namespace odbcpp {
+
+struct csv_options {
+    csv_options()
+        : delimiter(','), quote('"'), null_marker(), line_end("\r\n"),
+        header(true), quote_all(false), binary(binary_encoding::hex),
+        buffer_size(1 << 20) {}
+
+    char delimiter;
+    char quote;
+    // written for NULLs; text equal to it is quoted to tell them
+    // apart (empty strings as "", when it is empty)
+    std::string null_marker;
+    std::string line_end;
+    // a first row of field names
+    bool header;
+    // quote every character field, not just those which need it
+    bool quote_all;
+    // raw binary is quoted like character data
+    binary_encoding binary;
+    // output is written in chunks of this size
+    std::size_t buffer_size;
+};
+
+// tab-delimited, LF-terminated lines, quoting as for CSV
+inline csv_options tsv_options()
+{
+    csv_options options;
+    options.delimiter = '\t';
+    options.line_end = "\n";
+    return options;
+}
+
+// writes result sets as delimited text (RFC 4180 quoting) to a file
+// descriptor, formatting each field straight from the query's
+// buffers into a large output buffer
+class csv_writer {
+    public:
+        static const std::size_t all_rows = static_cast<std::size_t>(-1);
+
+        // fd stays open; it belongs to the caller
+        explicit csv_writer(int fd, const csv_options& options = csv_options());
+
+        csv_writer(const csv_writer&) = delete;
+
+        csv_writer& operator=(const csv_writer&) = delete;
+
+        // writes out any buffered text; errors are ignored
+        // (call flush() first)
+        ~csv_writer() noexcept;
+
+        // write up to max_rows of the query's remaining rows, preceded
+        // by the header (if enabled) the first time; returns rows written
+        std::size_t write_rows(query& q, std::size_t max_rows = all_rows);
+
+        void write_header(const std::vector<field>& fields);
+
+        void flush();
+
+        // including text still buffered
+        std::uint64_t bytes_written() const noexcept
+        {
+            return written_ + used_;
+        }
+
+    private:
+        int fd_;
+        csv_options options_;
+        std::unique_ptr<char[]> buffer_;
+        std::size_t capacity_;
+        std::size_t used_;
+        std::uint64_t written_;
+        bool header_written_;
+        // wide text, converted to UTF-8 before quoting
+        std::vector<char> scratch_;
+
+        // room for at least n more bytes, flushing or growing the buffer
+        char* reserve(std::size_t n);
+
+        void commit(char* end) noexcept { used_ = end - buffer_.get(); }
+
+        void write_raw(const char* s, std::size_t n);
+
+        void write_text(const char* s, std::size_t n);
+
+        void write_narrow(const SQLCHAR* s, std::size_t n);
+
+        void write_wide(const SQLWCHAR* s, std::size_t n);
+
+        void write_binary(const SQLCHAR* s, std::size_t n);
+
+        void write_field(const datum& d);
+};
+
+}
+
+#define ODBCPP_CSV_HPP
+#endif
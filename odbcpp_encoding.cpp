@@ -0,0 +1,248 @@
+#include "odbcpp_encoding.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ODBCPP_ENCODING_SSE2
+#endif
+
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#define ODBCPP_ENCODING_SSSE3
+#endif
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#define ODBCPP_ENCODING_AVX2
+#endif
+
+namespace odbcpp {
+
+namespace {
+
+const char hex_digits[] = "0123456789abcdef";
+
+const char base64_digits[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+inline char* hex_scalar(const unsigned char* bytes, std::size_t len,
+        char* out) noexcept
+{
+    for (std::size_t i = 0; i < len; ++i) {
+        *out++ = hex_digits[bytes[i] >> 4];
+        *out++ = hex_digits[bytes[i] & 0xf];
+    }
+    return out;
+}
+
+#ifdef ODBCPP_ENCODING_SSE2
+
+// nibbles to '0' - '9', 'a' - 'f'
+inline __m128i hex_digits_of(__m128i n) noexcept
+{
+    const __m128i letters = _mm_and_si128(
+            _mm_cmpgt_epi8(n, _mm_set1_epi8(9)),
+            _mm_set1_epi8('a' - '0' - 10));
+    return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')), letters);
+}
+
+// 16 bytes to 32 digits
+inline void hex_16(const unsigned char* bytes, char* out) noexcept
+{
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+    const __m128i lo = _mm_and_si128(v, mask);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+            hex_digits_of(_mm_unpacklo_epi8(hi, lo)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16),
+            hex_digits_of(_mm_unpackhi_epi8(hi, lo)));
+}
+
+#else
+
+inline void hex_16(const unsigned char* bytes, char* out) noexcept
+{
+    hex_scalar(bytes, 16, out);
+}
+
+#endif
+
+#ifdef ODBCPP_ENCODING_AVX2
+
+inline __m256i hex_digits_of(__m256i n) noexcept
+{
+    const __m256i letters = _mm256_and_si256(
+            _mm256_cmpgt_epi8(n, _mm256_set1_epi8(9)),
+            _mm256_set1_epi8('a' - '0' - 10));
+    return _mm256_add_epi8(_mm256_add_epi8(n, _mm256_set1_epi8('0')),
+            letters);
+}
+
+// 32 bytes to 64 digits
+inline void hex_32(const unsigned char* bytes, char* out) noexcept
+{
+    const __m256i v = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(bytes));
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), mask);
+    const __m256i lo = _mm256_and_si256(v, mask);
+
+    // unpacking works within 128-bit lanes: a holds bytes 0-7 and
+    // 16-23, b bytes 8-15 and 24-31
+    const __m256i a = _mm256_unpacklo_epi8(hi, lo);
+    const __m256i b = _mm256_unpackhi_epi8(hi, lo);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+            hex_digits_of(_mm256_permute2x128_si256(a, b, 0x20)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32),
+            hex_digits_of(_mm256_permute2x128_si256(a, b, 0x31)));
+}
+
+#endif
+
+#ifdef ODBCPP_ENCODING_SSSE3
+
+// 12 bytes (of the 16 loaded) to 16 digits (Muła's method)
+inline void base64_12(const unsigned char* bytes, char* out) noexcept
+{
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+
+    // each 32-bit lane gets one group of three bytes, as b1 b0 b2 b1
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(
+                10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    // and from those, four 6-bit indices, one per byte
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    const __m128i indices = _mm_or_si128(t1, t3);
+
+    // indices to digits, by an offset for each range:
+    // 0-25 'A', 26-51 'a', 52-61 '0', 62 '+', 63 '/'
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+
+    const __m128i offsets = _mm_setr_epi8(
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+            '/' - 63, 'A', 0, 0);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_add_epi8(
+                _mm_shuffle_epi8(offsets, range), indices));
+}
+
+#endif
+
+}
+
+std::size_t encoded_size(binary_encoding encoding, std::size_t len,
+        char separator) noexcept
+{
+    switch (encoding) {
+        case binary_encoding::hex:
+            return separator && len ? 3 * len - 1 : 2 * len;
+
+        case binary_encoding::base64:
+            return (len + 2) / 3 * 4;
+
+        default:
+            return len;
+    }
+}
+
+char* encode_binary(binary_encoding encoding, const unsigned char* bytes,
+        std::size_t len, char* out, char separator) noexcept
+{
+    switch (encoding) {
+        case binary_encoding::hex:
+            return encode_hex(bytes, len, out, separator);
+
+        case binary_encoding::base64:
+            return encode_base64(bytes, len, out);
+
+        default:
+            return std::copy(bytes, bytes + len, out);
+    }
+}
+
+char* encode_hex(const unsigned char* bytes, std::size_t len, char* out,
+        char separator) noexcept
+{
+    std::size_t i = 0;
+
+    if (separator) {
+        // digits a block at a time, then spread out
+        char digits[32];
+        while (i < len) {
+            std::size_t n = std::min<std::size_t>(len - i, 16);
+            if (n == 16)
+                hex_16(bytes + i, digits);
+            else
+                hex_scalar(bytes + i, n, digits);
+
+            for (std::size_t k = 0; k < n; ++k) {
+                if (i + k)
+                    *out++ = separator;
+                *out++ = digits[2 * k];
+                *out++ = digits[2 * k + 1];
+            }
+
+            i += n;
+        }
+
+        return out;
+    }
+
+#ifdef ODBCPP_ENCODING_AVX2
+    for (; i + 32 <= len; i += 32, out += 64)
+        hex_32(bytes + i, out);
+#endif
+
+    for (; i + 16 <= len; i += 16, out += 32)
+        hex_16(bytes + i, out);
+
+    return hex_scalar(bytes + i, len - i, out);
+}
+
+char* encode_base64(const unsigned char* bytes, std::size_t len,
+        char* out) noexcept
+{
+    std::size_t i = 0;
+
+#ifdef ODBCPP_ENCODING_SSSE3
+    // each step loads 16 bytes, for 12
+    for (; i + 16 <= len; i += 12, out += 16)
+        base64_12(bytes + i, out);
+#endif
+
+    for (; i + 3 <= len; i += 3) {
+        std::uint32_t v = (static_cast<std::uint32_t>(bytes[i]) << 16)
+            | (static_cast<std::uint32_t>(bytes[i + 1]) << 8) | bytes[i + 2];
+        *out++ = base64_digits[v >> 18];
+        *out++ = base64_digits[(v >> 12) & 0x3f];
+        *out++ = base64_digits[(v >> 6) & 0x3f];
+        *out++ = base64_digits[v & 0x3f];
+    }
+
+    if (i < len) {
+        std::uint32_t v = static_cast<std::uint32_t>(bytes[i]) << 16;
+        if (i + 1 < len)
+            v |= static_cast<std::uint32_t>(bytes[i + 1]) << 8;
+
+        *out++ = base64_digits[v >> 18];
+        *out++ = base64_digits[(v >> 12) & 0x3f];
+        *out++ = i + 1 < len ? base64_digits[(v >> 6) & 0x3f] : '=';
+        *out++ = '=';
+    }
+
+    return out;
+}
+
+}
@@ -0,0 +1,39 @@
+#ifndef ODBCPP_ENCODING_HPP
+
+#include <cstddef>
+
+namespace odbcpp {
+
+// binary data as text, written to caller-supplied buffers, which must
+// have room for encoded_size() bytes; each function returns the end of
+// the text (no terminator is written)
+// whole buffers are encoded 16 (SSE2) or 32 (AVX2) bytes at a time for
+// hex, and 12 at a time for base64 (SSSE3), where the build targets them
+
+enum class binary_encoding : char {
+    // lowercase, two digits per byte
+    hex,
+    // RFC 4648, with padding
+    base64,
+    // the bytes as they are
+    raw
+};
+
+// a separator only applies to hex, going between bytes ("de ad be ef");
+// '\0' for none
+std::size_t encoded_size(binary_encoding encoding, std::size_t len,
+        char separator = '\0') noexcept;
+
+char* encode_binary(binary_encoding encoding, const unsigned char* bytes,
+        std::size_t len, char* out, char separator = '\0') noexcept;
+
+char* encode_hex(const unsigned char* bytes, std::size_t len, char* out,
+        char separator = '\0') noexcept;
+
+char* encode_base64(const unsigned char* bytes, std::size_t len,
+        char* out) noexcept;
+
+}
+
+#define ODBCPP_ENCODING_HPP
+#endif
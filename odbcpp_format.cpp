@@ -0,0 +1,856 @@
+#include "odbcpp_format.hpp"
+#include "odbcpp_encoding.hpp"
+#include "odbcpp_unicode.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace odbcpp {
+
+namespace {
+
+const char digit_pairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+const char hex_digits[] = "0123456789abcdef";
+
+const std::uint64_t powers_of_10[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+    10000000ull, 100000000ull, 1000000000ull, 10000000000ull,
+    100000000000ull, 1000000000000ull, 10000000000000ull,
+    100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull,
+    10000000000000000000ull
+};
+
+// copy text assembled in a scratch buffer, if it fits
+char* copy_out(const char* text, const char* end, char* first, char* last)
+{
+    if (last - first < end - text)
+        return nullptr;
+    return std::copy(text, end, first);
+}
+
+int count_digits(std::uint64_t v)
+{
+    int n = 1;
+    while (true) {
+        if (v < 10)
+            return n;
+        if (v < 100)
+            return n + 1;
+        if (v < 1000)
+            return n + 2;
+        if (v < 10000)
+            return n + 3;
+        v /= 10000;
+        n += 4;
+    }
+}
+
+// two digits at a time, from the end
+char* write_uint(char* p, std::uint64_t v)
+{
+    char* end = p + count_digits(v);
+    char* q = end;
+    while (v >= 100) {
+        unsigned i = static_cast<unsigned>(v % 100) * 2;
+        v /= 100;
+        *--q = digit_pairs[i + 1];
+        *--q = digit_pairs[i];
+    }
+
+    if (v >= 10) {
+        unsigned i = static_cast<unsigned>(v) * 2;
+        *--q = digit_pairs[i + 1];
+        *--q = digit_pairs[i];
+    } else {
+        *--q = static_cast<char>('0' + v);
+    }
+
+    return end;
+}
+
+char* write_int(char* p, std::int64_t v)
+{
+    if (v < 0) {
+        *p++ = '-';
+        return write_uint(p, 0 - static_cast<std::uint64_t>(v));
+    }
+
+    return write_uint(p, static_cast<std::uint64_t>(v));
+}
+
+// zero-padded to two digits
+char* write_2(char* p, unsigned v)
+{
+    if (v >= 100)
+        return write_uint(p, v);
+
+    *p++ = digit_pairs[2 * v];
+    *p++ = digit_pairs[2 * v + 1];
+    return p;
+}
+
+// YYYY-MM-DD; years outside 0-9999 are written as they are
+char* write_date(char* p, SQLSMALLINT year, unsigned month, unsigned day)
+{
+    if (year >= 0 && year <= 9999) {
+        p = write_2(p, year / 100);
+        p = write_2(p, year % 100);
+    } else {
+        p = write_int(p, year);
+    }
+
+    *p++ = '-';
+    p = write_2(p, month);
+    *p++ = '-';
+    return write_2(p, day);
+}
+
+char* write_time(char* p, unsigned hour, unsigned minute, unsigned second)
+{
+    p = write_2(p, hour);
+    *p++ = ':';
+    p = write_2(p, minute);
+    *p++ = ':';
+    return write_2(p, second);
+}
+
+// a fraction of digits digits, as .ddd without trailing zeros
+// (nothing for zero)
+char* write_fraction(char* p, std::uint64_t fraction, int digits)
+{
+    fraction %= powers_of_10[digits];
+    if (fraction == 0)
+        return p;
+
+    while (fraction % 10 == 0) {
+        fraction /= 10;
+        --digits;
+    }
+
+    *p++ = '.';
+    for (int i = digits - 1; i >= 0; --i) {
+        p[i] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+
+    return p + digits;
+}
+
+char* write_hex(char* p, std::uint32_t v, int digits)
+{
+    for (int i = digits - 1; i >= 0; --i)
+        *p++ = hex_digits[(v >> (4 * i)) & 0xf];
+    return p;
+}
+
+// Grisu2 (F. Loitsch, "Printing Floating-Point Numbers Quickly and
+// Accurately with Integers", 2010), after R. Yip's formulation;
+// digits are shortest in all but a few cases, and always read back
+// as the same value
+
+struct diy_fp {
+    std::uint64_t f;
+    int e;
+};
+
+// normalized 64-bit significands and binary exponents of
+// 10^-348, 10^-340, ..., 10^340
+const diy_fp cached_powers[] = {
+    { 0xfa8fd5a0081c0288ull, -1220 },
+    { 0xbaaee17fa23ebf76ull, -1193 },
+    { 0x8b16fb203055ac76ull, -1166 },
+    { 0xcf42894a5dce35eaull, -1140 },
+    { 0x9a6bb0aa55653b2dull, -1113 },
+    { 0xe61acf033d1a45dfull, -1087 },
+    { 0xab70fe17c79ac6caull, -1060 },
+    { 0xff77b1fcbebcdc4full, -1034 },
+    { 0xbe5691ef416bd60cull, -1007 },
+    { 0x8dd01fad907ffc3cull, -980 },
+    { 0xd3515c2831559a83ull, -954 },
+    { 0x9d71ac8fada6c9b5ull, -927 },
+    { 0xea9c227723ee8bcbull, -901 },
+    { 0xaecc49914078536dull, -874 },
+    { 0x823c12795db6ce57ull, -847 },
+    { 0xc21094364dfb5637ull, -821 },
+    { 0x9096ea6f3848984full, -794 },
+    { 0xd77485cb25823ac7ull, -768 },
+    { 0xa086cfcd97bf97f4ull, -741 },
+    { 0xef340a98172aace5ull, -715 },
+    { 0xb23867fb2a35b28eull, -688 },
+    { 0x84c8d4dfd2c63f3bull, -661 },
+    { 0xc5dd44271ad3cdbaull, -635 },
+    { 0x936b9fcebb25c996ull, -608 },
+    { 0xdbac6c247d62a584ull, -582 },
+    { 0xa3ab66580d5fdaf6ull, -555 },
+    { 0xf3e2f893dec3f126ull, -529 },
+    { 0xb5b5ada8aaff80b8ull, -502 },
+    { 0x87625f056c7c4a8bull, -475 },
+    { 0xc9bcff6034c13053ull, -449 },
+    { 0x964e858c91ba2655ull, -422 },
+    { 0xdff9772470297ebdull, -396 },
+    { 0xa6dfbd9fb8e5b88full, -369 },
+    { 0xf8a95fcf88747d94ull, -343 },
+    { 0xb94470938fa89bcfull, -316 },
+    { 0x8a08f0f8bf0f156bull, -289 },
+    { 0xcdb02555653131b6ull, -263 },
+    { 0x993fe2c6d07b7facull, -236 },
+    { 0xe45c10c42a2b3b06ull, -210 },
+    { 0xaa242499697392d3ull, -183 },
+    { 0xfd87b5f28300ca0eull, -157 },
+    { 0xbce5086492111aebull, -130 },
+    { 0x8cbccc096f5088ccull, -103 },
+    { 0xd1b71758e219652cull, -77 },
+    { 0x9c40000000000000ull, -50 },
+    { 0xe8d4a51000000000ull, -24 },
+    { 0xad78ebc5ac620000ull, 3 },
+    { 0x813f3978f8940984ull, 30 },
+    { 0xc097ce7bc90715b3ull, 56 },
+    { 0x8f7e32ce7bea5c70ull, 83 },
+    { 0xd5d238a4abe98068ull, 109 },
+    { 0x9f4f2726179a2245ull, 136 },
+    { 0xed63a231d4c4fb27ull, 162 },
+    { 0xb0de65388cc8ada8ull, 189 },
+    { 0x83c7088e1aab65dbull, 216 },
+    { 0xc45d1df942711d9aull, 242 },
+    { 0x924d692ca61be758ull, 269 },
+    { 0xda01ee641a708deaull, 295 },
+    { 0xa26da3999aef774aull, 322 },
+    { 0xf209787bb47d6b85ull, 348 },
+    { 0xb454e4a179dd1877ull, 375 },
+    { 0x865b86925b9bc5c2ull, 402 },
+    { 0xc83553c5c8965d3dull, 428 },
+    { 0x952ab45cfa97a0b3ull, 455 },
+    { 0xde469fbd99a05fe3ull, 481 },
+    { 0xa59bc234db398c25ull, 508 },
+    { 0xf6c69a72a3989f5cull, 534 },
+    { 0xb7dcbf5354e9beceull, 561 },
+    { 0x88fcf317f22241e2ull, 588 },
+    { 0xcc20ce9bd35c78a5ull, 614 },
+    { 0x98165af37b2153dfull, 641 },
+    { 0xe2a0b5dc971f303aull, 667 },
+    { 0xa8d9d1535ce3b396ull, 694 },
+    { 0xfb9b7cd9a4a7443cull, 720 },
+    { 0xbb764c4ca7a44410ull, 747 },
+    { 0x8bab8eefb6409c1aull, 774 },
+    { 0xd01fef10a657842cull, 800 },
+    { 0x9b10a4e5e9913129ull, 827 },
+    { 0xe7109bfba19c0c9dull, 853 },
+    { 0xac2820d9623bf429ull, 880 },
+    { 0x80444b5e7aa7cf85ull, 907 },
+    { 0xbf21e44003acdd2dull, 933 },
+    { 0x8e679c2f5e44ff8full, 960 },
+    { 0xd433179d9c8cb841ull, 986 },
+    { 0x9e19db92b4e31ba9ull, 1013 },
+    { 0xeb96bf6ebadf77d9ull, 1039 },
+    { 0xaf87023b9bf0ee6bull, 1066 }
+};
+
+diy_fp normalize(diy_fp v)
+{
+    while (!(v.f & (1ull << 63))) {
+        v.f <<= 1;
+        --v.e;
+    }
+
+    return v;
+}
+
+// the upper 64 bits of the 128-bit product, rounded
+diy_fp multiply(diy_fp x, diy_fp y)
+{
+    const std::uint64_t mask = 0xffffffffu;
+    std::uint64_t a = x.f >> 32, b = x.f & mask;
+    std::uint64_t c = y.f >> 32, d = y.f & mask;
+    std::uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    std::uint64_t mid = (bd >> 32) + (ad & mask) + (bc & mask) + (1u << 31);
+    diy_fp r = { ac + (ad >> 32) + (bc >> 32) + (mid >> 32), x.e + y.e + 64 };
+    return r;
+}
+
+// a cached power c_mk with binary exponent putting e + c_mk.e + 64
+// in [-60, -32]; k receives its negated decimal exponent
+diy_fp cached_power(int e, int& k)
+{
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int ik = static_cast<int>(dk);
+    if (dk - ik > 0.0)
+        ++ik;
+
+    unsigned index = static_cast<unsigned>((ik >> 3) + 1);
+    k = -(-348 + static_cast<int>(index << 3));
+    return cached_powers[index];
+}
+
+void grisu_round(char* buffer, int len, std::uint64_t delta,
+        std::uint64_t rest, std::uint64_t ten_kappa, std::uint64_t wp_w)
+{
+    while (rest < wp_w && delta - rest >= ten_kappa
+            && (rest + ten_kappa < wp_w
+                || wp_w - rest > rest + ten_kappa - wp_w)) {
+        --buffer[len - 1];
+        rest += ten_kappa;
+    }
+}
+
+int digit_gen(diy_fp w, diy_fp mp, std::uint64_t delta, char* buffer,
+        int& k)
+{
+    const diy_fp one = { 1ull << -mp.e, mp.e };
+    const std::uint64_t wp_w = mp.f - w.f;
+    std::uint32_t p1 = static_cast<std::uint32_t>(mp.f >> -one.e);
+    std::uint64_t p2 = mp.f & (one.f - 1);
+    int kappa = count_digits(p1);
+    int len = 0;
+
+    while (kappa > 0) {
+        std::uint32_t div = static_cast<std::uint32_t>(powers_of_10[kappa - 1]);
+        std::uint32_t d = p1 / div;
+        p1 %= div;
+        if (d || len)
+            buffer[len++] = static_cast<char>('0' + d);
+        --kappa;
+
+        std::uint64_t rest = (static_cast<std::uint64_t>(p1) << -one.e) + p2;
+        if (rest <= delta) {
+            k += kappa;
+            grisu_round(buffer, len, delta, rest,
+                    powers_of_10[kappa] << -one.e, wp_w);
+            return len;
+        }
+    }
+
+    while (true) {
+        p2 *= 10;
+        delta *= 10;
+        char d = static_cast<char>(p2 >> -one.e);
+        if (d || len)
+            buffer[len++] = static_cast<char>('0' + d);
+        p2 &= one.f - 1;
+        --kappa;
+
+        if (p2 < delta) {
+            k += kappa;
+            int index = -kappa;
+            grisu_round(buffer, len, delta, p2, one.f,
+                    wp_w * (index < 20 ? powers_of_10[index] : 0));
+            return len;
+        }
+    }
+}
+
+// digits of the positive value f * 2^e; the neighbours half an ulp
+// away bound the digits, so a float's neighbours give a float's digits
+// lower_closer: f is a power of two, so the lower neighbour is nearer
+int grisu2(std::uint64_t f, int e, bool lower_closer, char* buffer, int& k)
+{
+    diy_fp v = { f, e };
+    diy_fp plus = normalize(diy_fp { (f << 1) + 1, e - 1 });
+    diy_fp minus = lower_closer ? diy_fp { (f << 2) - 1, e - 2 }
+        : diy_fp { (f << 1) - 1, e - 1 };
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    diy_fp c = cached_power(plus.e, k);
+    diy_fp w = multiply(normalize(v), c);
+    diy_fp wp = multiply(plus, c);
+    diy_fp wm = multiply(minus, c);
+    ++wm.f;
+    --wp.f;
+
+    return digit_gen(w, wp, wp.f - wm.f, buffer, k);
+}
+
+// digits * 10^k as plain decimal where that's reasonably short,
+// exponential otherwise
+char* prettify(char* p, const char* digits, int len, int k)
+{
+    const int kk = len + k;
+
+    if (k >= 0 && kk <= 21) {
+        // 1234e7 -> 12340000000
+        p = std::copy(digits, digits + len, p);
+        return std::fill_n(p, k, '0');
+    }
+
+    if (kk > 0 && kk <= 21) {
+        // 1234e-2 -> 12.34
+        p = std::copy(digits, digits + kk, p);
+        *p++ = '.';
+        return std::copy(digits + kk, digits + len, p);
+    }
+
+    if (kk > -6 && kk <= 0) {
+        // 1234e-6 -> 0.001234
+        *p++ = '0';
+        *p++ = '.';
+        p = std::fill_n(p, -kk, '0');
+        return std::copy(digits, digits + len, p);
+    }
+
+    // 1234e30 -> 1.234e+33
+    *p++ = digits[0];
+    if (len > 1) {
+        *p++ = '.';
+        p = std::copy(digits + 1, digits + len, p);
+    }
+
+    int exponent = kk - 1;
+    *p++ = 'e';
+    *p++ = exponent < 0 ? '-' : '+';
+    if (exponent < 0)
+        exponent = -exponent;
+    if (exponent < 10)
+        *p++ = '0';
+    return write_uint(p, static_cast<std::uint64_t>(exponent));
+}
+
+char* write_floating(char* p, bool negative, bool special, bool nan,
+        std::uint64_t f, int e, bool lower_closer)
+{
+    if (nan)
+        return std::copy("nan", "nan" + 3, p);
+
+    if (negative)
+        *p++ = '-';
+
+    if (special)
+        return std::copy("inf", "inf" + 3, p);
+
+    if (f == 0) {
+        *p++ = '0';
+        return p;
+    }
+
+    char digits[20];
+    int k;
+    int len = grisu2(f, e, lower_closer, digits, k);
+    return prettify(p, digits, len, k);
+}
+
+// the magnitude of a SQL_NUMERIC_STRUCT as decimal digits
+char* write_mantissa(char* p, const SQLCHAR* val)
+{
+    // base 2^32 limbs, most significant first
+    std::uint32_t limbs[4];
+    for (int i = 0; i < 4; ++i) {
+        const SQLCHAR* b = val + 4 * (3 - i);
+        limbs[i] = static_cast<std::uint32_t>(b[0])
+            | static_cast<std::uint32_t>(b[1]) << 8
+            | static_cast<std::uint32_t>(b[2]) << 16
+            | static_cast<std::uint32_t>(b[3]) << 24;
+    }
+
+    // nine digits at a time, least significant first
+    std::uint32_t groups[5];
+    int n_groups = 0;
+    bool nonzero = true;
+    while (nonzero) {
+        std::uint64_t rem = 0;
+        nonzero = false;
+        for (auto& limb : limbs) {
+            std::uint64_t cur = (rem << 32) | limb;
+            limb = static_cast<std::uint32_t>(cur / 1000000000u);
+            rem = cur % 1000000000u;
+            nonzero = nonzero || limb;
+        }
+        groups[n_groups++] = static_cast<std::uint32_t>(rem);
+    }
+
+    p = write_uint(p, groups[--n_groups]);
+    while (n_groups) {
+        std::uint32_t g = groups[--n_groups];
+        for (int i = 8; i >= 0; --i) {
+            p[i] = static_cast<char>('0' + g % 10);
+            g /= 10;
+        }
+        p += 9;
+    }
+
+    return p;
+}
+
+}
+
+char* format_integer(char* first, char* last, std::int64_t v)
+{
+    char text[24];
+    return copy_out(text, write_int(text, v), first, last);
+}
+
+char* format_unsigned(char* first, char* last, std::uint64_t v)
+{
+    char text[24];
+    return copy_out(text, write_uint(text, v), first, last);
+}
+
+char* format_double(char* first, char* last, double v)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+
+    const std::uint64_t fraction = bits & ((1ull << 52) - 1);
+    const int exponent = static_cast<int>((bits >> 52) & 0x7ff);
+
+    std::uint64_t f = exponent ? fraction | (1ull << 52) : fraction;
+    int e = exponent ? exponent - 1075 : -1074;
+
+    char text[32];
+    char* end = write_floating(text, bits >> 63, exponent == 0x7ff,
+            exponent == 0x7ff && fraction, f, e,
+            fraction == 0 && exponent > 1);
+    return copy_out(text, end, first, last);
+}
+
+char* format_float(char* first, char* last, float v)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+
+    const std::uint32_t fraction = bits & ((1u << 23) - 1);
+    const int exponent = static_cast<int>((bits >> 23) & 0xff);
+
+    std::uint64_t f = exponent ? fraction | (1u << 23) : fraction;
+    int e = exponent ? exponent - 150 : -149;
+
+    char text[32];
+    char* end = write_floating(text, bits >> 31, exponent == 0xff,
+            exponent == 0xff && fraction, f, e,
+            fraction == 0 && exponent > 1);
+    return copy_out(text, end, first, last);
+}
+
+char* format_date(char* first, char* last, const SQL_DATE_STRUCT& v)
+{
+    char text[24];
+    return copy_out(text, write_date(text, v.year, v.month, v.day),
+            first, last);
+}
+
+char* format_time(char* first, char* last, const SQL_TIME_STRUCT& v)
+{
+    char text[24];
+    return copy_out(text, write_time(text, v.hour, v.minute, v.second),
+            first, last);
+}
+
+char* format_timestamp(char* first, char* last, const SQL_TIMESTAMP_STRUCT& v)
+{
+    char text[48];
+    char* p = write_date(text, v.year, v.month, v.day);
+    *p++ = ' ';
+    p = write_time(p, v.hour, v.minute, v.second);
+    // fraction is in nanoseconds
+    p = write_fraction(p, v.fraction, 9);
+    return copy_out(text, p, first, last);
+}
+
+char* format_numeric(char* first, char* last, const SQL_NUMERIC_STRUCT& v)
+{
+    // 39 digits, or fewer with up to 127 zeros of scale either side
+    char digits[40];
+    char* end = write_mantissa(digits, v.val);
+    int len = static_cast<int>(end - digits);
+    bool zero = len == 1 && digits[0] == '0';
+    int scale = v.scale;
+
+    char text[192];
+    char* p = text;
+    // sign: 1 for positive, 0 for negative
+    if (v.sign == 0 && !zero)
+        *p++ = '-';
+
+    if (scale <= 0) {
+        p = std::copy(digits, end, p);
+        if (!zero)
+            p = std::fill_n(p, -scale, '0');
+    } else if (len > scale) {
+        p = std::copy(digits, digits + len - scale, p);
+        *p++ = '.';
+        p = std::copy(digits + len - scale, end, p);
+    } else {
+        *p++ = '0';
+        *p++ = '.';
+        p = std::fill_n(p, scale - len, '0');
+        p = std::copy(digits, end, p);
+    }
+
+    return copy_out(text, p, first, last);
+}
+
+char* format_guid(char* first, char* last, const SQLGUID& v)
+{
+    char text[36];
+    char* p = write_hex(text, v.Data1, 8);
+    *p++ = '-';
+    p = write_hex(p, v.Data2, 4);
+    *p++ = '-';
+    p = write_hex(p, v.Data3, 4);
+    *p++ = '-';
+    for (int i = 0; i < 8; ++i) {
+        if (i == 2)
+            *p++ = '-';
+        p = write_hex(p, v.Data4[i], 2);
+    }
+
+    return copy_out(text, p, first, last);
+}
+
+char* format_interval(char* first, char* last, const SQL_INTERVAL_STRUCT& v)
+{
+    const auto& ym = v.intval.year_month;
+    const auto& ds = v.intval.day_second;
+
+    char text[64];
+    char* p = text;
+    if (v.interval_sign == SQL_TRUE)
+        *p++ = '-';
+
+    switch (v.interval_type) {
+        case SQL_IS_YEAR:
+            p = write_uint(p, ym.year);
+            break;
+
+        case SQL_IS_MONTH:
+            p = write_uint(p, ym.month);
+            break;
+
+        case SQL_IS_YEAR_TO_MONTH:
+            p = write_uint(p, ym.year);
+            *p++ = '-';
+            p = write_2(p, ym.month);
+            break;
+
+        case SQL_IS_DAY:
+            p = write_uint(p, ds.day);
+            break;
+
+        case SQL_IS_HOUR:
+            p = write_uint(p, ds.hour);
+            break;
+
+        case SQL_IS_MINUTE:
+            p = write_uint(p, ds.minute);
+            break;
+
+        case SQL_IS_SECOND:
+            p = write_uint(p, ds.second);
+            p = write_fraction(p, ds.fraction, 6);
+            break;
+
+        case SQL_IS_DAY_TO_HOUR:
+            p = write_uint(p, ds.day);
+            *p++ = ' ';
+            p = write_2(p, ds.hour);
+            break;
+
+        case SQL_IS_DAY_TO_MINUTE:
+            p = write_uint(p, ds.day);
+            *p++ = ' ';
+            p = write_2(p, ds.hour);
+            *p++ = ':';
+            p = write_2(p, ds.minute);
+            break;
+
+        case SQL_IS_DAY_TO_SECOND:
+            p = write_uint(p, ds.day);
+            *p++ = ' ';
+            p = write_time(p, ds.hour, ds.minute, ds.second);
+            p = write_fraction(p, ds.fraction, 6);
+            break;
+
+        case SQL_IS_HOUR_TO_MINUTE:
+            p = write_uint(p, ds.hour);
+            *p++ = ':';
+            p = write_2(p, ds.minute);
+            break;
+
+        case SQL_IS_HOUR_TO_SECOND:
+            p = write_uint(p, ds.hour);
+            *p++ = ':';
+            p = write_2(p, ds.minute);
+            *p++ = ':';
+            p = write_2(p, ds.second);
+            p = write_fraction(p, ds.fraction, 6);
+            break;
+
+        case SQL_IS_MINUTE_TO_SECOND:
+            p = write_uint(p, ds.minute);
+            *p++ = ':';
+            p = write_2(p, ds.second);
+            p = write_fraction(p, ds.fraction, 6);
+            break;
+
+        default:
+            throw std::invalid_argument("Bad interval type!");
+    }
+
+    return copy_out(text, p, first, last);
+}
+
+char* format_utf8(char* first, char* last, const SQLWCHAR* s,
+        std::size_t len)
+{
+    // measured first only when the worst case might not fit
+    std::size_t room = last - first;
+    if (room < utf8_capacity(len) && room < utf8_size(s, len))
+        return nullptr;
+
+    return to_utf8(s, len, first);
+}
+
+char* format_hex(char* first, char* last, const unsigned char* bytes,
+        std::size_t len)
+{
+    if (static_cast<std::size_t>(last - first)
+            < encoded_size(binary_encoding::hex, len))
+        return nullptr;
+
+    return encode_hex(bytes, len, first);
+}
+
+std::size_t format_size(const datum& d)
+{
+    if (!d)
+        return 0;
+
+    if (d.type() == data_type::numeric)
+        return 192;
+
+    if (!detail::is_pointer_type(d.type()))
+        return 64;
+
+    switch (detail::odbc_c_tag_from_type(d.type())) {
+        case SQL_C_WCHAR:
+            return utf8_capacity(d.length());
+
+        case SQL_C_BINARY:
+            return 2 * d.length();
+
+        default:
+            return d.length();
+    }
+}
+
+char* format(char* first, char* last, const datum& d)
+{
+    if (!d)
+        return first;
+
+    switch (d.type()) {
+        case data_type::short_integer:
+            return format_integer(first, last,
+                    d.get<data_type::short_integer>());
+
+        case data_type::integer:
+            return format_integer(first, last, d.get<data_type::integer>());
+
+        case data_type::long_integer:
+            return format_integer(first, last,
+                    d.get<data_type::long_integer>());
+
+        case data_type::byte:
+            return format_integer(first, last, d.get<data_type::byte>());
+
+        case data_type::bit:
+            return format_unsigned(first, last,
+                    d.get<data_type::bit>() ? 1 : 0);
+
+        case data_type::single_float:
+            return format_float(first, last,
+                    d.get<data_type::single_float>());
+
+        case data_type::double_float:
+            return format_double(first, last,
+                    d.get<data_type::double_float>());
+
+        case data_type::default_float:
+            return format_double(first, last,
+                    d.get<data_type::default_float>());
+
+        case data_type::date:
+            return format_date(first, last, d.get<data_type::date>());
+
+        case data_type::time:
+            return format_time(first, last, d.get<data_type::time>());
+
+        case data_type::timestamp:
+            return format_timestamp(first, last,
+                    d.get<data_type::timestamp>());
+
+        case data_type::numeric:
+            return format_numeric(first, last, d.get<data_type::numeric>());
+
+        case data_type::guid:
+            return format_guid(first, last, d.get<data_type::guid>());
+
+#define FORMAT_INTERVAL_CASE(tag) \
+        case data_type::tag: \
+            return format_interval(first, last, d.get<data_type::tag>());
+
+        FORMAT_INTERVAL_CASE(interval_year)
+        FORMAT_INTERVAL_CASE(interval_month)
+        FORMAT_INTERVAL_CASE(interval_day)
+        FORMAT_INTERVAL_CASE(interval_hour)
+        FORMAT_INTERVAL_CASE(interval_minute)
+        FORMAT_INTERVAL_CASE(interval_second)
+        FORMAT_INTERVAL_CASE(interval_year_to_month)
+        FORMAT_INTERVAL_CASE(interval_day_to_hour)
+        FORMAT_INTERVAL_CASE(interval_day_to_minute)
+        FORMAT_INTERVAL_CASE(interval_day_to_second)
+        FORMAT_INTERVAL_CASE(interval_hour_to_minute)
+        FORMAT_INTERVAL_CASE(interval_hour_to_second)
+        FORMAT_INTERVAL_CASE(interval_minute_to_second)
+
+#undef FORMAT_INTERVAL_CASE
+
+#define FORMAT_TEXT_CASE(tag) \
+        case data_type::tag: \
+            return copy_out(reinterpret_cast<const char*>( \
+                        d.get<data_type::tag>()), \
+                    reinterpret_cast<const char*>( \
+                        d.get<data_type::tag>()) + d.length(), \
+                    first, last);
+
+        FORMAT_TEXT_CASE(character)
+        FORMAT_TEXT_CASE(varchar)
+        FORMAT_TEXT_CASE(long_varchar)
+
+#undef FORMAT_TEXT_CASE
+
+        case data_type::wide_character:
+            return format_utf8(first, last,
+                    d.get<data_type::wide_character>(), d.length());
+
+        case data_type::wide_varchar:
+            return format_utf8(first, last,
+                    d.get<data_type::wide_varchar>(), d.length());
+
+        case data_type::long_wide_varchar:
+            return format_utf8(first, last,
+                    d.get<data_type::long_wide_varchar>(), d.length());
+
+        case data_type::binary:
+            return format_hex(first, last, d.get<data_type::binary>(),
+                    d.length());
+
+        case data_type::varbinary:
+            return format_hex(first, last, d.get<data_type::varbinary>(),
+                    d.length());
+
+        case data_type::long_varbinary:
+            return format_hex(first, last, d.get<data_type::long_varbinary>(),
+                    d.length());
+    }
+
+    throw std::invalid_argument("Bad type tag!");
+}
+
+}
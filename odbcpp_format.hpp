@@ -0,0 +1,63 @@
+#ifndef ODBCPP_FORMAT_HPP
+
+#include <cstdint>
+
+#include "odbcpp.hpp"
+
+namespace odbcpp {
+
+// text formatting into caller-supplied buffers, without allocating or
+// consulting the locale
+// each function writes to [first, last) and returns the end of the
+// text (no terminator is written), or nullptr if it doesn't fit
+
+// the datum's value as text; a NULL writes nothing
+//   numbers         shortest text which reads back as the same value
+//   bit             0 or 1
+//   date, time      YYYY-MM-DD, HH:MM:SS
+//   timestamp       YYYY-MM-DD HH:MM:SS[.fffffffff], without trailing zeros
+//   numeric         exact decimal, at the value's scale
+//   guid            xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx
+//   intervals       the SQL literal's text, e.g. -1-06, 3 04:05:06.5
+//   character       as is; wide text as UTF-8
+//   binary          lowercase hex
+char* format(char* first, char* last, const datum& d);
+
+// enough room for any text format() writes for d
+std::size_t format_size(const datum& d);
+
+char* format_integer(char* first, char* last, std::int64_t v);
+
+char* format_unsigned(char* first, char* last, std::uint64_t v);
+
+// shortest round-trip form (Grisu2): 0.1, 1e+30, 1.5e-07, -0, inf, nan
+char* format_double(char* first, char* last, double v);
+
+char* format_float(char* first, char* last, float v);
+
+char* format_date(char* first, char* last, const SQL_DATE_STRUCT& v);
+
+char* format_time(char* first, char* last, const SQL_TIME_STRUCT& v);
+
+char* format_timestamp(char* first, char* last, const SQL_TIMESTAMP_STRUCT& v);
+
+char* format_numeric(char* first, char* last, const SQL_NUMERIC_STRUCT& v);
+
+char* format_guid(char* first, char* last, const SQLGUID& v);
+
+// fractional seconds are taken to be microseconds (the default
+// interval seconds precision)
+char* format_interval(char* first, char* last, const SQL_INTERVAL_STRUCT& v);
+
+// UTF-16 (or UTF-32, where SQLWCHAR is 4 bytes) to UTF-8;
+// unpaired surrogates become U+FFFD
+char* format_utf8(char* first, char* last, const SQLWCHAR* s,
+        std::size_t len);
+
+char* format_hex(char* first, char* last, const unsigned char* bytes,
+        std::size_t len);
+
+}
+
+#define ODBCPP_FORMAT_HPP
+#endif
@@ -0,0 +1,25 @@
+#include "odbcpp_lob.hpp"
+
+namespace odbcpp {
+
+lob_streambuf::lob_streambuf(query& q, std::size_t field,
+        std::size_t chunk_size)
+    : q_(&q), field_(field), buf_(chunk_size)
+{
+    setg(buf_.data(), buf_.data(), buf_.data());
+}
+
+lob_streambuf::int_type lob_streambuf::underflow()
+{
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+
+    std::size_t n = q_->read(field_, buf_.data(), buf_.size());
+    if (n == 0)
+        return traits_type::eof();
+
+    setg(buf_.data(), buf_.data(), buf_.data() + n);
+    return traits_type::to_int_type(*gptr());
+}
+
+}
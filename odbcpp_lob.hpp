@@ -0,0 +1,63 @@
+#ifndef ODBCPP_LOB_HPP
+
+#include <istream>
+#include <streambuf>
+#include <vector>
+
+#include "odbcpp.hpp"
+
+namespace odbcpp {
+
+// streams a character or binary field of a query's current row in
+// fixed-size chunks (see query::read), in constant memory
+// wide character data comes through as raw SQLWCHAR bytes
+class lob_streambuf : public std::streambuf {
+    public:
+        static const std::size_t default_chunk_size = 64 * 1024;
+
+        lob_streambuf(query& q, std::size_t field,
+                std::size_t chunk_size = default_chunk_size);
+
+    protected:
+        int_type underflow() override;
+
+    private:
+        query* q_;
+        std::size_t field_;
+        std::vector<char> buf_;
+};
+
+class lob_istream : public std::istream {
+    public:
+        lob_istream(query& q, std::size_t field,
+                std::size_t chunk_size = lob_streambuf::default_chunk_size)
+            : std::istream(nullptr), buf_(q, field, chunk_size)
+        {
+            rdbuf(&buf_);
+        }
+
+    private:
+        lob_streambuf buf_;
+};
+
+// call fn(const char* data, std::size_t bytes) for each chunk of a
+// field, returning the total size
+template<class Fn>
+std::size_t read_chunks(query& q, std::size_t field, Fn fn,
+        std::size_t chunk_size = lob_streambuf::default_chunk_size)
+{
+    std::vector<char> buf(chunk_size);
+    std::size_t total = 0;
+
+    while (std::size_t n = q.read(field, buf.data(), buf.size())) {
+        fn(static_cast<const char*>(buf.data()), n);
+        total += n;
+    }
+
+    return total;
+}
+
+}
+
+#define ODBCPP_LOB_HPP
+#endif
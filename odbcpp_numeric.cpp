@@ -0,0 +1,271 @@
+#include "odbcpp_numeric.hpp"
+#include "odbcpp_format.hpp"
+
+#include <cstdlib>
+#include <stdexcept>
+
+namespace odbcpp {
+
+namespace {
+
+const std::uint64_t powers_of_10[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+    10000000ull, 100000000ull, 1000000000ull, 10000000000ull,
+    100000000000ull, 1000000000000ull, 10000000000000ull,
+    100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull,
+    10000000000000000000ull
+};
+
+// the powers of 10 a double holds exactly
+const double exact_powers_of_10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+[[noreturn]] void out_of_range()
+{
+    throw std::overflow_error("Numeric value out of range!");
+}
+
+// 128-bit unsigned arithmetic on two halves, for rescaling
+struct magnitude {
+    std::uint64_t lo;
+    std::uint64_t hi;
+};
+
+inline std::uint64_t load_le64(const SQLCHAR* p) noexcept
+{
+    std::uint64_t v = 0;
+    for (int i = 7; i >= 0; --i)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+inline magnitude magnitude_of(const SQL_NUMERIC_STRUCT& v) noexcept
+{
+    return { load_le64(v.val), load_le64(v.val + 8) };
+}
+
+void mul10(magnitude& m)
+{
+    // (2^128 - 1) / 10
+    if (m.hi > 0x1999999999999999u
+            || (m.hi == 0x1999999999999999u && m.lo > 0x9999999999999999u))
+        out_of_range();
+
+    std::uint64_t lo8 = m.lo << 3;
+    std::uint64_t lo = lo8 + (m.lo << 1);
+    std::uint64_t carry = (m.lo >> 61) + (m.lo >> 63) + (lo < lo8 ? 1 : 0);
+    m.hi = m.hi * 10 + carry;
+    m.lo = lo;
+}
+
+void div10(magnitude& m) noexcept
+{
+    std::uint64_t limbs[4] = {
+        m.hi >> 32, m.hi & 0xffffffffu, m.lo >> 32, m.lo & 0xffffffffu
+    };
+
+    std::uint64_t rem = 0;
+    for (auto& limb : limbs) {
+        std::uint64_t cur = (rem << 32) | limb;
+        limb = cur / 10;
+        rem = cur % 10;
+    }
+
+    m.hi = (limbs[0] << 32) | limbs[1];
+    m.lo = (limbs[2] << 32) | limbs[3];
+}
+
+// from one scale to another; the usual case, where they're the same
+// or the magnitude fits 64 bits, takes no loop
+inline void rescale(magnitude& m, int from, int to)
+{
+    if (from == to || (m.hi == 0 && m.lo == 0))
+        return;
+
+    if (m.hi == 0) {
+        if (to < from) {
+            m.lo = from - to < 20 ? m.lo / powers_of_10[from - to] : 0;
+            return;
+        }
+
+        if (to - from < 20 && m.lo <= ~0ull / powers_of_10[to - from]) {
+            m.lo *= powers_of_10[to - from];
+            return;
+        }
+    }
+
+    for (; from < to; ++from)
+        mul10(m);
+    for (; from > to; --from)
+        div10(m);
+}
+
+inline std::int64_t to_units(const SQL_NUMERIC_STRUCT& v, int scale)
+{
+    magnitude m = magnitude_of(v);
+    rescale(m, v.scale, scale);
+
+    // sign: 1 for positive, 0 for negative
+    const bool negative = v.sign == 0;
+    if (m.hi || m.lo > (negative ? 1ull << 63 : (1ull << 63) - 1))
+        out_of_range();
+
+    return static_cast<std::int64_t>(negative ? 0 - m.lo : m.lo);
+}
+
+// digits and an exponent, which strtod reads the same in any locale
+double parse_double(const SQL_NUMERIC_STRUCT& v)
+{
+    SQL_NUMERIC_STRUCT digits = v;
+    digits.sign = 1;
+    digits.scale = 0;
+
+    char text[64];
+    char* p = format_numeric(text, text + 40, digits);
+    *p++ = 'e';
+    p = format_integer(p, text + sizeof(text) - 1, -v.scale);
+    *p = '\0';
+    return std::strtod(text, nullptr);
+}
+
+inline double to_double(const SQL_NUMERIC_STRUCT& v)
+{
+    magnitude m = magnitude_of(v);
+
+    double d;
+    if (m.hi == 0 && m.lo < (1ull << 53) && v.scale >= -22 && v.scale <= 22) {
+        // both operands are exact, so this rounds once, correctly
+        d = v.scale >= 0
+            ? static_cast<double>(m.lo) / exact_powers_of_10[v.scale]
+            : static_cast<double>(m.lo) * exact_powers_of_10[-v.scale];
+    } else {
+        d = parse_double(v);
+    }
+
+    return v.sign == 0 && d != 0 ? -d : d;
+}
+
+inline void to_decimal128(const SQL_NUMERIC_STRUCT& v, int scale,
+        unsigned char* out)
+{
+    magnitude m = magnitude_of(v);
+    rescale(m, v.scale, scale);
+
+    if (v.sign == 0) {
+        m.lo = ~m.lo + 1;
+        m.hi = ~m.hi + (m.lo == 0 ? 1 : 0);
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<unsigned char>(m.lo >> (8 * i));
+        out[i + 8] = static_cast<unsigned char>(m.hi >> (8 * i));
+    }
+}
+
+#ifdef ODBCPP_HAS_INT128
+
+__extension__ typedef unsigned __int128 uint128;
+
+// n <= 38
+inline uint128 power_of_10(int n) noexcept
+{
+    uint128 p = 1;
+    while (n--)
+        p *= 10;
+    return p;
+}
+
+inline int128 to_int128(const SQL_NUMERIC_STRUCT& v, int scale)
+{
+    const magnitude m = magnitude_of(v);
+    uint128 u = (static_cast<uint128>(m.hi) << 64) | m.lo;
+
+    // 10^39 > 2^128
+    if (scale > v.scale && u) {
+        const int n = scale - v.scale;
+        if (n > 38)
+            out_of_range();
+        const uint128 p = power_of_10(n);
+        if (u > ~static_cast<uint128>(0) / p)
+            out_of_range();
+        u *= p;
+    } else if (scale < v.scale) {
+        const int n = v.scale - scale;
+        u = n > 38 ? 0 : u / power_of_10(n);
+    }
+
+    const bool negative = v.sign == 0;
+    const uint128 limit = static_cast<uint128>(1) << 127;
+    if (u > (negative ? limit : limit - 1))
+        out_of_range();
+
+    return static_cast<int128>(negative ? 0 - u : u);
+}
+
+#endif
+
+}
+
+#ifdef ODBCPP_HAS_INT128
+
+int128 numeric_to_int128(const SQL_NUMERIC_STRUCT& v, int scale)
+{
+    return to_int128(v, scale);
+}
+
+void numeric_to_int128(const SQL_NUMERIC_STRUCT* v, std::size_t n,
+        int scale, int128* out)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_int128(v[i], scale);
+}
+
+#endif
+
+fixed64 numeric_to_fixed64(const SQL_NUMERIC_STRUCT& v, int scale)
+{
+    return { to_units(v, scale), scale };
+}
+
+void numeric_to_fixed64(const SQL_NUMERIC_STRUCT* v, std::size_t n,
+        int scale, std::int64_t* out)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_units(v[i], scale);
+}
+
+double numeric_to_double(const SQL_NUMERIC_STRUCT& v)
+{
+    return to_double(v);
+}
+
+void numeric_to_double(const SQL_NUMERIC_STRUCT* v, std::size_t n,
+        double* out)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_double(v[i]);
+}
+
+std::string numeric_to_string(const SQL_NUMERIC_STRUCT& v)
+{
+    char text[192];
+    return std::string(text, format_numeric(text, text + sizeof(text), v));
+}
+
+void numeric_to_decimal128(const SQL_NUMERIC_STRUCT& v, int scale,
+        unsigned char* out)
+{
+    to_decimal128(v, scale, out);
+}
+
+void numeric_to_decimal128(const SQL_NUMERIC_STRUCT* v, std::size_t n,
+        int scale, unsigned char* out)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        to_decimal128(v[i], scale, out + 16 * i);
+}
+
+}
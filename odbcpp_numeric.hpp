@@ -0,0 +1,68 @@
+#ifndef ODBCPP_NUMERIC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "odbcpp.hpp"
+
+namespace odbcpp {
+
+// decoding of SQL_NUMERIC_STRUCT: a sign (1 for positive, 0 for
+// negative) and a 16-byte little-endian magnitude, at the value's own
+// scale (value = magnitude * 10^-scale)
+// numeric and decimal columns are fetched at the field's precision and
+// decimal_digits, so a query's values are already at the field's scale
+// decoding to another scale truncates toward zero; values which don't
+// fit the result type throw std::overflow_error
+
+#ifdef __SIZEOF_INT128__
+#define ODBCPP_HAS_INT128
+__extension__ typedef __int128 int128;
+#endif
+
+// a decimal as a count of 10^-scale units
+struct fixed64 {
+    std::int64_t units;
+    int scale;
+};
+
+#ifdef ODBCPP_HAS_INT128
+// the value in units of 10^-scale
+int128 numeric_to_int128(const SQL_NUMERIC_STRUCT& v, int scale);
+#endif
+
+fixed64 numeric_to_fixed64(const SQL_NUMERIC_STRUCT& v, int scale);
+
+// the nearest double
+double numeric_to_double(const SQL_NUMERIC_STRUCT& v);
+
+// exact, at the value's scale (as format_numeric)
+std::string numeric_to_string(const SQL_NUMERIC_STRUCT& v);
+
+// 16 bytes of little-endian two's complement in units of 10^-scale
+// (Arrow's decimal128)
+void numeric_to_decimal128(const SQL_NUMERIC_STRUCT& v, int scale,
+        unsigned char* out);
+
+// n values at a time, e.g. a numeric column's values() (whose NULLs are
+// zeroed, and decode to 0); fixed64 results are the units alone
+
+#ifdef ODBCPP_HAS_INT128
+void numeric_to_int128(const SQL_NUMERIC_STRUCT* v, std::size_t n,
+        int scale, int128* out);
+#endif
+
+void numeric_to_fixed64(const SQL_NUMERIC_STRUCT* v, std::size_t n,
+        int scale, std::int64_t* out);
+
+void numeric_to_double(const SQL_NUMERIC_STRUCT* v, std::size_t n,
+        double* out);
+
+void numeric_to_decimal128(const SQL_NUMERIC_STRUCT* v, std::size_t n,
+        int scale, unsigned char* out);
+
+}
+
+#define ODBCPP_NUMERIC_HPP
+#endif
@@ -0,0 +1,382 @@
+#include "odbcpp_partition.hpp"
+#include "odbcpp_format.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <utility>
+
+namespace odbcpp {
+
+namespace {
+
+std::string integer_text(std::int64_t v)
+{
+    char buf[24];
+    return std::string(buf, format_integer(buf, buf + sizeof(buf), v));
+}
+
+bool same_shape(const std::vector<field>& a, const std::vector<field>& b)
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (std::size_t i = 0; i < a.size(); ++i)
+        if (a[i].type != b[i].type)
+            return false;
+
+    return true;
+}
+
+// no more workers than the pool has connections: a worker left waiting
+// on the pool behind others blocked on a slow consumer would time out
+std::size_t worker_count(const partition_options& options,
+        const connection_pool& pool, std::size_t partitions)
+{
+    return std::min<std::size_t>(std::min<std::size_t>(
+                std::max<std::size_t>(options.workers, 1),
+                pool.options().max_size), partitions);
+}
+
+}
+
+partition_spec partition_spec::ranges(const std::string& column,
+        const std::vector<std::int64_t>& bounds)
+{
+    if (!std::is_sorted(bounds.begin(), bounds.end())
+            || std::adjacent_find(bounds.begin(), bounds.end())
+               != bounds.end())
+        throw std::invalid_argument("Partition bounds must be ascending!");
+
+    partition_spec spec;
+    if (bounds.empty()) {
+        spec.predicates.push_back("1 = 1");
+        return spec;
+    }
+
+    spec.predicates.push_back(column + " < " + integer_text(bounds.front())
+            + " OR " + column + " IS NULL");
+    for (std::size_t i = 1; i < bounds.size(); ++i)
+        spec.predicates.push_back(
+                column + " >= " + integer_text(bounds[i - 1])
+                + " AND " + column + " < " + integer_text(bounds[i]));
+    spec.predicates.push_back(column + " >= " + integer_text(bounds.back()));
+
+    return spec;
+}
+
+partition_spec partition_spec::modulo(const std::string& column,
+        std::size_t n)
+{
+    if (n == 0)
+        throw std::invalid_argument("Partition count must be > 0!");
+
+    partition_spec spec;
+    const std::string mod = "{fn MOD({fn ABS(" + column + ")}, "
+        + integer_text(n) + ")}";
+    for (std::size_t i = 0; i < n; ++i) {
+        spec.predicates.push_back(mod + " = " + integer_text(i));
+        if (i == 0)
+            spec.predicates.back() += " OR " + column + " IS NULL";
+    }
+
+    return spec;
+}
+
+std::vector<string> partition_statements(const std::string& statement,
+        const partition_spec& spec)
+{
+    if (spec.predicates.empty())
+        throw std::invalid_argument("No partitions!");
+
+    const std::string placeholder(partition_placeholder);
+    auto pos = statement.find(placeholder);
+    if (pos == std::string::npos)
+        throw std::invalid_argument(
+                "Partitioned statement has no {partition} placeholder!");
+
+    std::vector<string> statements;
+    statements.reserve(spec.predicates.size());
+    for (const auto& predicate : spec.predicates) {
+        std::string s(statement);
+        s.replace(pos, placeholder.size(), "(" + predicate + ")");
+        statements.push_back(make_string(s));
+    }
+
+    return statements;
+}
+
+void scan_partitions(connection_pool& pool, const std::string& statement,
+        const partition_spec& spec,
+        const std::function<void(std::size_t partition, query& q)>& consumer,
+        const partition_options& options)
+{
+    const auto statements = partition_statements(statement, spec);
+
+    std::atomic<std::size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::exception_ptr> errors(statements.size());
+
+    auto work = [&] {
+        while (!failed) {
+            std::size_t p = next++;
+            if (p >= statements.size())
+                return;
+
+            try {
+                // the pool checks connections on the way out, so one
+                // left broken by an error isn't handed out again
+                auto conn = pool.acquire();
+                auto q = conn->make_query();
+                q.set_fetch_size(options.fetch_size);
+                q.execute(statements[p]);
+                consumer(p, q);
+            } catch (...) {
+                errors[p] = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    const std::size_t n = worker_count(options, pool, statements.size());
+    workers.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        workers.emplace_back(work);
+
+    for (auto& w : workers)
+        w.join();
+
+    for (const auto& e : errors)
+        if (e)
+            std::rethrow_exception(e);
+}
+
+partitioned_query::partitioned_query(connection_pool& pool,
+        const std::string& statement, const partition_spec& spec,
+        const partition_options& options)
+    : pool_(pool), statements_(partition_statements(statement, spec)),
+    options_(options), fields_(), names_(), states_(statements_.size()),
+    free_(), next_(0), stop_(false), mutex_(), filled_(), emptied_(),
+    current_(), partition_(0), row_(0), workers_()
+{
+    if (options_.batch_rows == 0)
+        options_.batch_rows = 1;
+
+    if (options_.depth == 0)
+        options_.depth = 1;
+
+    const std::size_t n = worker_count(options_, pool_, statements_.size());
+    workers_.reserve(n);
+
+    try {
+        for (std::size_t i = 0; i < n; ++i)
+            workers_.emplace_back([this] { run(); });
+
+        // the first partition's fields stand for them all
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            filled_.wait(lock, [this] {
+                return states_[0].described || states_[0].done;
+            });
+            fields_ = states_[0].fields;
+        }
+
+        for (std::size_t i = 0; i < fields_.size(); ++i)
+            names_[fields_[i].name] = i;
+
+        acquire();
+    } catch (...) {
+        shutdown();
+        throw;
+    }
+}
+
+partitioned_query::~partitioned_query() noexcept
+{
+    shutdown();
+}
+
+const datum& partitioned_query::at(std::size_t field) const
+{
+    if (row_ >= current_.rows)
+        throw std::runtime_error("No current row!");
+
+    if (field >= fields_.size())
+        throw std::out_of_range("Invalid field index!");
+
+    return current_.cells[row_ * fields_.size() + field];
+}
+
+void partitioned_query::advance()
+{
+    if (row_ >= current_.rows)
+        throw std::runtime_error("No current row!");
+
+    if (++row_ < current_.rows)
+        return;
+
+    acquire();
+}
+
+void partitioned_query::acquire()
+{
+    row_ = 0;
+
+    while (partition_ < states_.size()) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto& s = states_[partition_];
+        filled_.wait(lock, [&s] { return !s.full.empty() || s.done; });
+
+        if (!s.full.empty()) {
+            free_.push_back(std::move(current_));
+            current_ = std::move(s.full.front());
+            s.full.pop_front();
+            lock.unlock();
+            emptied_.notify_all();
+
+            // written before any of the partition's batches
+            if (!same_shape(s.fields, fields_)) {
+                current_.rows = 0;
+                partition_ = states_.size();
+                throw std::runtime_error("Partition fields differ!");
+            }
+
+            if (current_.rows)
+                return;
+
+            continue;
+        }
+
+        auto error = s.error;
+        lock.unlock();
+
+        if (error) {
+            current_.rows = 0;
+            partition_ = states_.size();
+            std::rethrow_exception(error);
+        }
+
+        ++partition_;
+    }
+
+    current_.rows = 0;
+}
+
+void partitioned_query::run()
+{
+    // take the next partition, if any are left to scan
+    auto claim = [this](std::size_t& p) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_ || next_ == statements_.size())
+            return false;
+        p = next_++;
+        return true;
+    };
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stop_ || next_ == statements_.size())
+                return;
+        }
+
+        // lease the connection before claiming a partition: otherwise
+        // a worker waiting on the pool could hold the partition read
+        // next, while the connection it waits for sits with a later
+        // partition blocked on its full queue
+        std::size_t p = 0;
+        bool claimed = false;
+        std::exception_ptr error;
+        try {
+            auto conn = pool_.acquire();
+            claimed = claim(p);
+            if (!claimed)
+                return;
+            scan(p, *conn);
+        } catch (...) {
+            error = std::current_exception();
+            // a failed lease fails the partition it was for
+            if (!claimed && !claim(p))
+                return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            states_[p].done = true;
+            states_[p].error = error;
+        }
+        filled_.notify_one();
+    }
+}
+
+void partitioned_query::scan(std::size_t partition, connection& conn)
+{
+    auto q = conn.make_query();
+    q.set_fetch_size(options_.fetch_size);
+    q.execute(statements_[partition]);
+
+    auto& state = states_[partition];
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        state.fields = q.fields();
+        state.described = true;
+    }
+    filled_.notify_one();
+
+    const std::size_t n = q.fields().size();
+
+    while (q) {
+        batch b;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            emptied_.wait(lock, [this, &state] {
+                return stop_ || state.full.size() < options_.depth;
+            });
+
+            if (stop_)
+                return;
+
+            if (!free_.empty()) {
+                b = std::move(free_.back());
+                free_.pop_back();
+            }
+        }
+
+        // copy-assignment keeps each cell's buffer from batch to batch
+        b.rows = 0;
+        while (b.rows < options_.batch_rows && q) {
+            std::size_t base = b.rows * n;
+            for (std::size_t i = 0; i < n; ++i) {
+                if (base + i < b.cells.size())
+                    b.cells[base + i] = q.at(i);
+                else
+                    b.cells.push_back(q.at(i));
+            }
+
+            ++b.rows;
+            q.advance();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state.full.push_back(std::move(b));
+        }
+        filled_.notify_one();
+    }
+}
+
+void partitioned_query::shutdown() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    emptied_.notify_all();
+
+    for (auto& w : workers_)
+        if (w.joinable())
+            w.join();
+}
+
+}
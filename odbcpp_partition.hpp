@@ -0,0 +1,150 @@
+#ifndef ODBCPP_PARTITION_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "odbcpp.hpp"
+#include "odbcpp_pool.hpp"
+
+namespace odbcpp {
+
+// where each partition's predicate goes in a partitioned statement, e.g.
+//   select * from sales where {partition} and region = 'west'
+constexpr const char* partition_placeholder = "{partition}";
+
+// the predicates splitting a scan into partitions; between them they
+// must select every row exactly once
+struct partition_spec {
+    std::vector<std::string> predicates;
+
+    // column < b0 (or NULL), b0 <= column < b1, ..., column >= bn-1;
+    // bounds must be ascending
+    static partition_spec ranges(const std::string& column,
+            const std::vector<std::int64_t>& bounds);
+
+    // {fn MOD({fn ABS(column)}, n)} = 0, 1, ... n - 1;
+    // NULLs go with partition 0
+    static partition_spec modulo(const std::string& column, std::size_t n);
+};
+
+// the statement for each partition: the placeholder (its first
+// occurrence) replaced by the partition's predicate, parenthesized
+std::vector<string> partition_statements(const std::string& statement,
+        const partition_spec& spec);
+
+struct partition_options {
+    partition_options()
+        : workers(4), fetch_size(256), batch_rows(256), depth(4) {}
+
+    // threads, each scanning a partition at a time on a connection
+    // leased from the pool (capped at the pool's max_size)
+    std::size_t workers;
+    std::size_t fetch_size;
+    // for partitioned_query: rows copied per batch, and batches
+    // fetched ahead per partition
+    std::size_t batch_rows;
+    std::size_t depth;
+};
+
+// execute every partition and call consumer with each executed query,
+// on up to options.workers threads at once, in no particular order
+// the first error stops the workers taking on further partitions,
+// and is rethrown once the others have finished
+void scan_partitions(connection_pool& pool, const std::string& statement,
+        const partition_spec& spec,
+        const std::function<void(std::size_t partition, query& q)>& consumer,
+        const partition_options& options = partition_options());
+
+// a partitioned scan read as one stream of rows, partition by partition
+// in the spec's order (so range partitions, each ordered by their key,
+// come out in key order); the following partitions are fetched ahead
+// on the worker threads, up to options.depth batches each
+// every partition must have the same fields
+class partitioned_query {
+    public:
+        partitioned_query(connection_pool& pool, const std::string& statement,
+                const partition_spec& spec,
+                const partition_options& options = partition_options());
+
+        partitioned_query(const partitioned_query&) = delete;
+
+        partitioned_query& operator=(const partitioned_query&) = delete;
+
+        // stops the workers after their current batches
+        ~partitioned_query() noexcept;
+
+        explicit operator bool() const noexcept { return row_ < current_.rows; }
+
+        const std::vector<field>& fields() const noexcept { return fields_; }
+
+        // the partition the current row comes from
+        std::size_t partition() const noexcept { return partition_; }
+
+        // valid until the next advance()
+        const datum& at(std::size_t field) const;
+
+        const datum& at(const std::string& field) const
+        {
+            return at(names_.at(field));
+        }
+
+        // a partition's errors are thrown here, once the rows before
+        // them have been consumed
+        void advance();
+
+    private:
+        struct batch {
+            // row-major, fields_.size() cells per row
+            std::vector<datum> cells;
+            std::size_t rows;
+        };
+
+        struct partition_state {
+            std::deque<batch> full;
+            std::vector<field> fields;
+            bool described;
+            bool done;
+            std::exception_ptr error;
+        };
+
+        connection_pool& pool_;
+        std::vector<string> statements_;
+        partition_options options_;
+        std::vector<field> fields_;
+        std::unordered_map<std::string, std::size_t> names_;
+        std::vector<partition_state> states_;
+        // emptied batches, for reuse of their cells
+        std::vector<batch> free_;
+        // the next partition for a worker to take on
+        std::size_t next_;
+        bool stop_;
+        std::mutex mutex_;
+        std::condition_variable filled_;
+        std::condition_variable emptied_;
+        batch current_;
+        std::size_t partition_;
+        std::size_t row_;
+        std::vector<std::thread> workers_;
+
+        void run();
+
+        void scan(std::size_t partition, connection& conn);
+
+        // wait for the next batch with rows, or the end of the scan
+        void acquire();
+
+        void shutdown() noexcept;
+};
+
+}
+
+#define ODBCPP_PARTITION_HPP
+#endif
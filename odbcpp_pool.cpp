@@ -0,0 +1,191 @@
+#include "odbcpp_pool.hpp"
+
+#include <exception>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace odbcpp {
+
+connection_pool::connection_pool(const string& conn_str,
+        const pool_options& options)
+    : conn_str_(conn_str), options_(options), mutex_(), available_(),
+    idle_(), total_(0)
+{
+    if (options_.max_size == 0)
+        throw std::invalid_argument("Connection pool max size must be > 0!");
+
+    if (options_.min_size > options_.max_size)
+        options_.min_size = options_.max_size;
+}
+
+void connection_pool::warm()
+{
+    std::size_t count;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        count = total_ < options_.min_size ? options_.min_size - total_ : 0;
+        total_ += count;
+    }
+
+    if (count == 0)
+        return;
+
+    std::vector<std::exception_ptr> errors(count);
+    std::vector<std::thread> workers;
+    workers.reserve(count);
+
+    try {
+        for (std::size_t i = 0; i < count; ++i) {
+            workers.emplace_back([this, i, &errors] {
+                try {
+                    auto conn = open();
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    idle_.push_back({ std::move(conn), clock::now() });
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    --total_;
+                }
+                available_.notify_one();
+            });
+        }
+    } catch (...) {
+        // a thread failed to start: the rest were never opened
+        for (auto& w : workers)
+            w.join();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            total_ -= count - workers.size();
+        }
+        available_.notify_all();
+        throw;
+    }
+
+    for (auto& w : workers)
+        w.join();
+
+    for (const auto& e : errors)
+        if (e)
+            std::rethrow_exception(e);
+}
+
+connection_pool::lease connection_pool::acquire()
+{
+    auto deadline = clock::now() + options_.acquire_timeout;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        if (!idle_.empty()) {
+            auto conn = std::move(idle_.back().conn);
+            idle_.pop_back();
+            lock.unlock();
+
+            if (conn->alive())
+                return lease(this, std::move(conn));
+
+            conn.reset();
+            lock.lock();
+            --total_;
+            continue;
+        }
+
+        if (total_ < options_.max_size) {
+            ++total_;
+            lock.unlock();
+
+            try {
+                return lease(this, open());
+            } catch (...) {
+                lock.lock();
+                --total_;
+                available_.notify_one();
+                throw;
+            }
+        }
+
+        if (available_.wait_until(lock, deadline) == std::cv_status::timeout
+                && idle_.empty() && total_ >= options_.max_size)
+            throw std::runtime_error(
+                    "Timed out waiting for a pooled connection!");
+    }
+}
+
+std::size_t connection_pool::evict_idle()
+{
+    std::vector<std::unique_ptr<connection>> closing;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        collect_expired(closing);
+    }
+
+    return closing.size();
+}
+
+std::size_t connection_pool::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return total_;
+}
+
+std::size_t connection_pool::idle() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
+
+std::unique_ptr<connection> connection_pool::open()
+{
+    std::unique_ptr<connection> conn(new connection());
+    if (!conn->connect(conn_str_))
+        throw std::runtime_error("Unable to open pooled connection!");
+
+    return conn;
+}
+
+void connection_pool::release(std::unique_ptr<connection> conn,
+        bool discard) noexcept
+{
+    // the next lease starts in autocommit, whatever this one left open
+    if (!discard && conn->in_transaction()) {
+        try {
+            conn->rollback();
+        } catch (...) {
+            discard = true;
+        }
+    }
+
+    // disconnecting may take a round trip, so do it outside the lock
+    std::vector<std::unique_ptr<connection>> closing;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (discard) {
+            --total_;
+            closing.push_back(std::move(conn));
+        } else {
+            idle_.push_back({ std::move(conn), clock::now() });
+        }
+
+        collect_expired(closing);
+    }
+
+    available_.notify_one();
+}
+
+void connection_pool::collect_expired(
+        std::vector<std::unique_ptr<connection>>& closing)
+{
+    if (options_.idle_timeout.count() <= 0)
+        return;
+
+    auto cutoff = clock::now() - options_.idle_timeout;
+    while (!idle_.empty() && total_ > options_.min_size
+            && idle_.front().since < cutoff) {
+        closing.push_back(std::move(idle_.front().conn));
+        idle_.pop_front();
+        --total_;
+    }
+}
+
+}
@@ -0,0 +1,141 @@
+#ifndef ODBCPP_POOL_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "odbcpp.hpp"
+
+namespace odbcpp {
+
+struct pool_options {
+    pool_options()
+        : min_size(0), max_size(8),
+        idle_timeout(std::chrono::minutes(5)),
+        acquire_timeout(std::chrono::seconds(30)) {}
+
+    // connections opened by warm() and never evicted;
+    // min_size == max_size gives a fixed-size pool
+    std::size_t min_size;
+    std::size_t max_size;
+    // idle connections beyond min_size are closed after this long
+    // (zero disables eviction)
+    std::chrono::milliseconds idle_timeout;
+    // how long acquire() waits for a connection when the pool is full
+    std::chrono::milliseconds acquire_timeout;
+};
+
+// a thread-safe pool of connections sharing one connection string
+// the lock is held only to push or pop an idle connection;
+// connecting and disconnecting happen outside it
+// the pool must outlive every lease
+class connection_pool {
+    public:
+        class lease {
+            public:
+                lease(const lease&) = delete;
+
+                lease(lease&& other) noexcept
+                    : pool_(other.pool_), conn_(std::move(other.conn_)),
+                    discard_(other.discard_) {}
+
+                lease& operator=(const lease&) = delete;
+
+                lease& operator=(lease&& other) noexcept
+                {
+                    release();
+                    pool_ = other.pool_;
+                    conn_ = std::move(other.conn_);
+                    discard_ = other.discard_;
+                    return *this;
+                }
+
+                ~lease() noexcept { release(); }
+
+                connection& operator*() const noexcept { return *conn_; }
+
+                connection* operator->() const noexcept { return conn_.get(); }
+
+                // close the connection on return instead of reusing it
+                // (e.g. after an error which left it in a bad state)
+                void discard() noexcept { discard_ = true; }
+
+            private:
+                connection_pool* pool_;
+                std::unique_ptr<connection> conn_;
+                bool discard_;
+
+                lease(connection_pool* pool, std::unique_ptr<connection> conn)
+                    : pool_(pool), conn_(std::move(conn)), discard_(false) {}
+
+                void release() noexcept
+                {
+                    if (conn_)
+                        pool_->release(std::move(conn_), discard_);
+                }
+
+            friend class connection_pool;
+        };
+
+        connection_pool(const string& conn_str,
+                const pool_options& options = pool_options());
+
+        template<class StrType>
+        connection_pool(const StrType& conn_str,
+                const pool_options& options = pool_options())
+            : connection_pool(make_string(conn_str), options) {}
+
+        connection_pool(const connection_pool&) = delete;
+
+        connection_pool& operator=(const connection_pool&) = delete;
+
+        // open connections up to min_size, in parallel
+        void warm();
+
+        // an idle connection which passes connection::alive(),
+        // or a new one if the pool isn't full
+        lease acquire();
+
+        // close connections idle longer than the idle timeout
+        // (also done whenever a connection is returned)
+        std::size_t evict_idle();
+
+        // open connections, leased or idle
+        std::size_t size() const;
+
+        std::size_t idle() const;
+
+        const pool_options& options() const noexcept { return options_; }
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        struct idle_connection {
+            std::unique_ptr<connection> conn;
+            clock::time_point since;
+        };
+
+        string conn_str_;
+        pool_options options_;
+        mutable std::mutex mutex_;
+        std::condition_variable available_;
+        // most recently returned at the back
+        std::deque<idle_connection> idle_;
+        // open connections plus connections being opened
+        std::size_t total_;
+
+        std::unique_ptr<connection> open();
+
+        void release(std::unique_ptr<connection> conn, bool discard) noexcept;
+
+        // requires mutex_ held; moves expired connections into closing
+        void collect_expired(std::vector<std::unique_ptr<connection>>& closing);
+};
+
+}
+
+#define ODBCPP_POOL_HPP
+#endif
@@ -0,0 +1,158 @@
+#include "odbcpp_prefetch.hpp"
+
+#include <stdexcept>
+
+namespace odbcpp {
+
+prefetch_query::prefetch_query(query& q, const prefetch_options& options)
+    : q_(q), fields_(q.fields()), names_(), batch_rows_(options.batch_rows),
+    ring_(options.depth ? options.depth : 1), head_(0), tail_(0), full_(0),
+    stop_(false), mutex_(), filled_(), emptied_(), current_(nullptr), row_(0),
+    thread_()
+{
+    if (batch_rows_ == 0)
+        batch_rows_ = 1;
+
+    for (std::size_t i = 0; i < fields_.size(); ++i)
+        names_[fields_[i].name] = i;
+
+    for (auto& b : ring_) {
+        b.rows = 0;
+        b.last = false;
+    }
+
+    thread_ = std::thread([this] { run(); });
+
+    try {
+        acquire();
+    } catch (...) {
+        shutdown();
+        throw;
+    }
+}
+
+prefetch_query::~prefetch_query() noexcept
+{
+    shutdown();
+}
+
+const datum& prefetch_query::at(std::size_t field) const
+{
+    if (row_ >= current_->rows)
+        throw std::runtime_error("No current row!");
+
+    if (field >= fields_.size())
+        throw std::out_of_range("Invalid field index!");
+
+    return current_->cells[row_ * fields_.size() + field];
+}
+
+void prefetch_query::advance()
+{
+    if (row_ >= current_->rows)
+        throw std::runtime_error("No current row!");
+
+    if (++row_ < current_->rows || current_->last) {
+        if (row_ == current_->rows && current_->error)
+            std::rethrow_exception(current_->error);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        head_ = (head_ + 1) % ring_.size();
+        --full_;
+    }
+    emptied_.notify_one();
+
+    acquire();
+}
+
+void prefetch_query::acquire()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        filled_.wait(lock, [this] { return full_ > 0; });
+    }
+
+    current_ = &ring_[head_];
+    row_ = 0;
+
+    if (current_->rows == 0 && current_->error)
+        std::rethrow_exception(current_->error);
+}
+
+void prefetch_query::run()
+{
+    while (true) {
+        batch* b;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            emptied_.wait(lock, [this] {
+                return stop_ || full_ < ring_.size();
+            });
+
+            if (stop_)
+                return;
+
+            // the consumer never touches a batch which isn't full
+            b = &ring_[tail_];
+        }
+
+        fill(*b);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tail_ = (tail_ + 1) % ring_.size();
+            ++full_;
+        }
+        filled_.notify_one();
+
+        if (b->last)
+            return;
+    }
+}
+
+void prefetch_query::fill(batch& b)
+{
+    const std::size_t n = fields_.size();
+
+    b.rows = 0;
+    b.last = false;
+    b.error = nullptr;
+
+    try {
+        while (b.rows < batch_rows_ && q_) {
+            // copy-assignment keeps each cell's buffer from lap to lap
+            std::size_t base = b.rows * n;
+            for (std::size_t i = 0; i < n; ++i) {
+                if (base + i < b.cells.size())
+                    b.cells[base + i] = q_.at(i);
+                else
+                    b.cells.push_back(q_.at(i));
+            }
+
+            ++b.rows;
+            q_.advance();
+        }
+
+        b.last = !q_;
+    } catch (...) {
+        b.error = std::current_exception();
+        b.last = true;
+    }
+}
+
+void prefetch_query::shutdown() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    emptied_.notify_one();
+
+    if (thread_.joinable())
+        thread_.join();
+}
+
+}
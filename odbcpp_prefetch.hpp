@@ -0,0 +1,102 @@
+#ifndef ODBCPP_PREFETCH_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "odbcpp.hpp"
+
+namespace odbcpp {
+
+struct prefetch_options {
+    prefetch_options()
+        : depth(4), batch_rows(256) {}
+
+    // batches fetched ahead of the consumer; the fetch thread waits
+    // when all of them are full, so memory stays bounded by
+    // depth * batch_rows rows
+    std::size_t depth;
+    std::size_t batch_rows;
+};
+
+// reads an executed query's rows ahead of the consumer on a dedicated
+// thread, so fetching overlaps with processing the rows
+// rows are copied into a ring of batches whose cells are reused, and
+// handed over a batch at a time
+// the query belongs to the fetch thread until the prefetch_query is
+// destroyed, and is left part way through its results if it is
+// destroyed early
+class prefetch_query {
+    public:
+        explicit prefetch_query(query& q,
+                const prefetch_options& options = prefetch_options());
+
+        prefetch_query(const prefetch_query&) = delete;
+
+        prefetch_query& operator=(const prefetch_query&) = delete;
+
+        // stops the fetch thread after its current batch
+        ~prefetch_query() noexcept;
+
+        explicit operator bool() const noexcept { return row_ < current_->rows; }
+
+        const std::vector<field>& fields() const noexcept { return fields_; }
+
+        // valid until the next advance()
+        const datum& at(std::size_t field) const;
+
+        const datum& at(const std::string& field) const
+        {
+            return at(names_.at(field));
+        }
+
+        // fetch errors are thrown here, once the rows before them
+        // have been consumed
+        void advance();
+
+    private:
+        struct batch {
+            // row-major, fields_.size() cells per row
+            std::vector<datum> cells;
+            std::size_t rows;
+            // no batches follow this one
+            bool last;
+            std::exception_ptr error;
+        };
+
+        query& q_;
+        std::vector<field> fields_;
+        std::unordered_map<std::string, std::size_t> names_;
+        std::size_t batch_rows_;
+        std::vector<batch> ring_;
+        // consumer's batch, next batch to fill, and full batches
+        std::size_t head_;
+        std::size_t tail_;
+        std::size_t full_;
+        bool stop_;
+        std::mutex mutex_;
+        std::condition_variable filled_;
+        std::condition_variable emptied_;
+        const batch* current_;
+        std::size_t row_;
+        std::thread thread_;
+
+        void run();
+
+        void fill(batch& b);
+
+        // wait for the batch at head_
+        void acquire();
+
+        // stop and join the fetch thread
+        void shutdown() noexcept;
+};
+
+}
+
+#define ODBCPP_PREFETCH_HPP
+#endif
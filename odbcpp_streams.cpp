@@ -1,13 +1,92 @@
 #include "odbcpp_streams.hpp"
+#include "odbcpp_encoding.hpp"
+#include "odbcpp_format.hpp"
+#include "odbcpp_unicode.hpp"
 
+#include <algorithm>
 #include <iomanip>
 
-#define DIRECT_OUTPUT_CASE(type, datum, str) \
-    case data_type::type: \
-        return str << datum.get<data_type::type>();
-
 namespace odbcpp {
 
+namespace {
+
+// room for any fixed-size type's text
+const std::size_t format_buffer_size = 256;
+
+// wide text and binary data are converted a chunk at a time
+const std::size_t wide_chunk_size = 256;
+
+const std::size_t binary_chunk_size = 1024;
+
+// byte and bit keep their stream forms (hex, bool)
+bool formats_directly(data_type type)
+{
+    using namespace odbcpp::detail;
+    return !is_narrow_char_type(type)
+        && (is_scalar_type(type) || is_struct_type(type));
+}
+
+const SQLWCHAR* wide_text(const datum& d)
+{
+    switch (d.type()) {
+        case data_type::wide_character:
+            return d.get<data_type::wide_character>();
+
+        case data_type::wide_varchar:
+            return d.get<data_type::wide_varchar>();
+
+        case data_type::long_wide_varchar:
+            return d.get<data_type::long_wide_varchar>();
+
+        default:
+            throw std::invalid_argument("Unknown wide character type!");
+    }
+}
+
+void write_ascii(std::ostream& os, const char* first, const char* last)
+{
+    os.write(first, last - first);
+}
+
+void write_ascii(std::wostream& os, const char* first, const char* last)
+{
+    wchar_t text[format_buffer_size];
+    while (first != last) {
+        std::size_t n = std::min<std::size_t>(last - first,
+                sizeof(text) / sizeof(text[0]));
+        std::copy(first, first + n, text);
+        os.write(text, n);
+        first += n;
+    }
+}
+
+// bytes as hex, separated by spaces
+template<class StreamType>
+StreamType& write_hex(StreamType& os, const unsigned char* bytes,
+        std::size_t len)
+{
+    char text[3 * binary_chunk_size];
+    for (std::size_t i = 0; i < len; i += binary_chunk_size) {
+        std::size_t n = std::min(len - i, binary_chunk_size);
+        char* p = text;
+        if (i)
+            *p++ = ' ';
+        write_ascii(os, text, encode_hex(bytes + i, n, p, ' '));
+    }
+    return os;
+}
+
+// the units of the next chunk, keeping surrogate pairs together
+std::size_t wide_chunk(const SQLWCHAR* s, std::size_t len)
+{
+    std::size_t n = std::min(len, wide_chunk_size);
+    if (n < len && sizeof(SQLWCHAR) == 2 && (s[n - 1] & 0xfc00) == 0xd800)
+        --n;
+    return n;
+}
+
+}
+
 std::ostream& operator<<(std::ostream& os, const odbcpp::datum& d)
 {
     using namespace odbcpp::detail;
@@ -57,95 +136,30 @@ std::ostream& operator<<(std::ostream& os, const odbcpp::datum& d)
             case data_type::long_varbinary:
                 up = d.get<data_type::long_varbinary>();
 walk_binary:
-                fill = os.fill('0');
-                os << std::hex;
-                for (std::size_t i = 0; i < d.length(); ++i)
-                    os << (i ? " " : "") << std::setw(2)
-                        << static_cast<unsigned>(up[i]);
-                os << std::dec;
-                os.fill(fill);
-                return os;
+                return write_hex(os, up, d.length());
 
             default:
                 throw std::invalid_argument("Unknown character type!");
         }
     }
 
+    // wide text goes out as UTF-8
     if (is_wide_char_type(d.type())) {
-        switch (d.type()) {
-            wchar_t* p;
-
-            case data_type::wide_character:
-                p = d.get<data_type::wide_character>();
-                goto walk_wide;
-
-            case data_type::wide_varchar:
-                p = d.get<data_type::wide_varchar>();
-                goto walk_wide;
-
-            case data_type::long_wide_varchar:
-                p = d.get<data_type::long_wide_varchar>();
-walk_wide:
-                while (wchar_t c = *p++)
-                    os << os.narrow(c, '?');
-                return os;
-
-            default:
-                throw std::invalid_argument("Unknown wide character type!");
+        const SQLWCHAR* p = wide_text(d);
+        char text[utf8_capacity(wide_chunk_size)];
+        for (std::size_t left = d.length(); left; ) {
+            std::size_t n = wide_chunk(p, left);
+            os.write(text, to_utf8(p, n, text) - text);
+            p += n;
+            left -= n;
         }
+        return os;
     }
 
-    if (is_scalar_type(d.type())) {
-        switch (d.type()) {
-            DIRECT_OUTPUT_CASE(short_integer, d, os)
-            DIRECT_OUTPUT_CASE(integer, d, os)
-            DIRECT_OUTPUT_CASE(long_integer, d, os)
-            DIRECT_OUTPUT_CASE(single_float, d, os)
-            DIRECT_OUTPUT_CASE(double_float, d, os)
-            DIRECT_OUTPUT_CASE(default_float, d, os)
-
-            default:
-                return os << "<" << type_name(d.type()) << ">";
-        }
-    }
-
-    if (is_struct_type(d.type())) {
-        switch (d.type()) {
-            char fill;
-
-            case data_type::date:
-                fill = os.fill('0');
-                os << d.get<data_type::date>().year << "-"
-                    << std::setw(2) << d.get<data_type::date>().month << "-"
-                    << std::setw(2) << d.get<data_type::date>().day;
-                os.fill(fill);
-                return os;
-
-            case data_type::time:
-                fill = os.fill('0');
-                os << std::setw(2) << d.get<data_type::time>().hour << ":"
-                    << std::setw(2) << d.get<data_type::time>().minute << ":"
-                    << std::setw(2) << d.get<data_type::time>().second;
-                os.fill(fill);
-                return os;
-
-            case data_type::timestamp:
-                fill = os.fill('0');
-                os << d.get<data_type::timestamp>().year << "-"
-                    << std::setw(2) << d.get<data_type::timestamp>().month << "-"
-                    << std::setw(2) << d.get<data_type::timestamp>().day << " "
-                    << std::setw(2) << d.get<data_type::timestamp>().hour << ":"
-                    << std::setw(2) << d.get<data_type::timestamp>().minute << ":"
-                    << std::setw(2) << d.get<data_type::timestamp>().second;
-                if (d.get<data_type::timestamp>().fraction != 0.0)
-                    os << "+" << d.get<data_type::timestamp>().fraction
-                        << "e-9";
-                os.fill(fill);
-                return os;
-
-            default:
-                return os << "<" << type_name(d.type()) << ">";
-        }
+    if (is_scalar_type(d.type()) || is_struct_type(d.type())) {
+        char text[format_buffer_size];
+        char* end = format(text, text + sizeof(text), d);
+        return os.write(text, end - text);
     }
 
     if (is_pointer_type(d.type()))
@@ -162,19 +176,15 @@ std::wostream& operator<<(std::wostream& os, const odbcpp::datum& d)
         return os << "<NULL>";
 
     if (is_wide_char_type(d.type())) {
-        switch (d.type()) {
-            case data_type::wide_character:
-                return os << d.get<data_type::wide_character>();
-
-            case data_type::wide_varchar:
-                return os << d.get<data_type::wide_varchar>();
-
-            case data_type::long_wide_varchar:
-                return os << d.get<data_type::long_wide_varchar>();
-
-            default:
-                throw std::invalid_argument("Unknown wide character type!");
+        const SQLWCHAR* p = wide_text(d);
+        wchar_t text[wide_chunk_size];
+        for (std::size_t left = d.length(); left; ) {
+            std::size_t n = wide_chunk(p, left);
+            os.write(text, to_wchar(p, n, text) - text);
+            p += n;
+            left -= n;
         }
+        return os;
     }
 
     if (is_narrow_char_type(d.type())) {
@@ -222,77 +232,55 @@ walk_narrow:
             case data_type::long_varbinary:
                 up = d.get<data_type::long_varbinary>();
 walk_binary:
-                fill = os.fill('0');
-                os << std::hex;
-                for (std::size_t i = 0; i < d.length(); ++i)
-                    os << (i ? " " : "") << std::setw(2)
-                        << static_cast<unsigned>(up[i]);
-                os << std::dec;
-                os.fill(fill);
-                return os;
+                return write_hex(os, up, d.length());
 
             default:
                 throw std::invalid_argument("Unknown character type!");
         }
     }
 
-    if (is_scalar_type(d.type())) {
-        switch (d.type()) {
-            DIRECT_OUTPUT_CASE(short_integer, d, os)
-            DIRECT_OUTPUT_CASE(integer, d, os)
-            DIRECT_OUTPUT_CASE(long_integer, d, os)
-            DIRECT_OUTPUT_CASE(single_float, d, os)
-            DIRECT_OUTPUT_CASE(double_float, d, os)
-            DIRECT_OUTPUT_CASE(default_float, d, os)
-
-            default:
-                return os << "<" << type_name(d.type()) << ">";
-        }
+    if (is_scalar_type(d.type()) || is_struct_type(d.type())) {
+        char text[format_buffer_size];
+        write_ascii(os, text, format(text, text + sizeof(text), d));
+        return os;
     }
 
-    if (is_struct_type(d.type())) {
-        switch (d.type()) {
-            char fill;
-
-            case data_type::date:
-                fill = os.fill('0');
-                os << d.get<data_type::date>().year << "-"
-                    << std::setw(2) << d.get<data_type::date>().month << "-"
-                    << std::setw(2) << d.get<data_type::date>().day;
-                os.fill(fill);
-                return os;
+    if (is_pointer_type(d.type()))
+        throw std::runtime_error("Unknown pointer type!");
 
-            case data_type::time:
-                fill = os.fill('0');
-                os << std::setw(2) << d.get<data_type::time>().hour << ":"
-                    << std::setw(2) << d.get<data_type::time>().minute << ":"
-                    << std::setw(2) << d.get<data_type::time>().second;
-                os.fill(fill);
-                return os;
+    throw std::runtime_error("Unknown type!");
+}
 
-            case data_type::timestamp:
-                fill = os.fill('0');
-                os << d.get<data_type::timestamp>().year << "-"
-                    << std::setw(2) << d.get<data_type::timestamp>().month << "-"
-                    << std::setw(2) << d.get<data_type::timestamp>().day << " "
-                    << std::setw(2) << d.get<data_type::timestamp>().hour << ":"
-                    << std::setw(2) << d.get<data_type::timestamp>().minute << ":"
-                    << std::setw(2) << d.get<data_type::timestamp>().second;
-                if (d.get<data_type::timestamp>().fraction != 0.0)
-                    os << "+" << d.get<data_type::timestamp>().fraction
-                        << "e-9";
-                os.fill(fill);
-                return os;
+std::string to_string(const datum& d)
+{
+    if (!d)
+        return "<NULL>";
 
-            default:
-                return os << "<" << type_name(d.type()) << ">";
-        }
+    if (formats_directly(d.type())) {
+        char text[format_buffer_size];
+        return std::string(text, format(text, text + sizeof(text), d));
     }
 
-    if (is_pointer_type(d.type()))
-        throw std::runtime_error("Unknown pointer type!");
+    std::stringstream s;
+    s << d;
+    return s.str();
+}
 
-    throw std::runtime_error("Unknown type!");
+std::wstring to_wstring(const datum& d)
+{
+    if (!d)
+        return L"<NULL>";
+
+    if (formats_directly(d.type())) {
+        char text[format_buffer_size];
+        char* end = format(text, text + sizeof(text), d);
+        // the text is ASCII
+        return std::wstring(text, end);
+    }
+
+    std::wstringstream s;
+    s << d;
+    return s.str();
 }
 
 }
@@ -24,32 +24,20 @@ inline StreamType& operator<<(StreamType& os, const data_type& t)
     return os << type_name(t);
 }
 
-inline std::string to_string(const datum& d)
-{
-    std::stringstream s;
-    s << d;
-    return s.str();
-}
+// numbers, dates and times go through format() (odbcpp_format.hpp),
+// without a stream
+std::string to_string(const datum& d);
 
-inline std::wstring to_wstring(const datum& d)
-{
-    std::wstringstream s;
-    s << d;
-    return s.str();
-}
+std::wstring to_wstring(const datum& d);
 
 inline std::string to_string(const std::shared_ptr<datum>& p)
 {
-    std::stringstream s;
-    s << *p;
-    return s.str();
+    return to_string(*p);
 }
 
 inline std::wstring to_wstring(const std::shared_ptr<datum>& p)
 {
-    std::wstringstream s;
-    s << *p;
-    return s.str();
+    return to_wstring(*p);
 }
 
 }
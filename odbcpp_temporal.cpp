@@ -0,0 +1,440 @@
+#include "odbcpp_temporal.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace odbcpp {
+
+namespace {
+
+// days from 0000-03-01 to 1970-01-01
+const std::int64_t epoch_days = 719468;
+
+// the calendar repeats every 400 years (146097 days); shifting dates
+// forward by enough of those keeps any SQLSMALLINT year positive, so
+// the arithmetic is unsigned and needs no branches
+// (H. Hinnant's days_from_civil and civil_from_days)
+const std::int64_t shift_eras = 83;
+const std::int64_t shift_years = 400 * shift_eras;
+const std::int64_t shift_days = 146097 * shift_eras;
+
+inline std::int64_t days_from_civil(std::int64_t y, unsigned m, unsigned d)
+    noexcept
+{
+    // years start in March, so the leap day comes last
+    const unsigned jan_feb = m <= 2;
+    const std::uint64_t year =
+        static_cast<std::uint64_t>(y + shift_years - jan_feb);
+    const std::uint64_t era = year / 400;
+    const std::uint64_t yoe = year - era * 400;
+    const std::uint64_t doy = (153 * (m + 12 * jan_feb - 3) + 2) / 5
+        + static_cast<std::uint64_t>(d) - 1;
+    const std::uint64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return static_cast<std::int64_t>(era * 146097 + doe)
+        - epoch_days - shift_days;
+}
+
+struct civil {
+    std::int64_t year;
+    unsigned month;
+    unsigned day;
+};
+
+inline civil civil_from_days(std::int64_t days) noexcept
+{
+    const std::uint64_t z = static_cast<std::uint64_t>(days)
+        + static_cast<std::uint64_t>(epoch_days + shift_days);
+    const std::uint64_t era = z / 146097;
+    const std::uint64_t doe = z - era * 146097;
+    const std::uint64_t yoe =
+        (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const std::uint64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const std::uint64_t mp = (5 * doy + 2) / 153;
+
+    civil c;
+    c.day = static_cast<unsigned>(doy - (153 * mp + 2) / 5 + 1);
+    c.month = static_cast<unsigned>(mp + 3 - 12 * (mp >= 10));
+    c.year = static_cast<std::int64_t>(era * 400 + yoe) - shift_years
+        + (c.month <= 2);
+    return c;
+}
+
+// floor division, with the (non-negative) remainder
+inline std::int64_t floor_div(std::int64_t a, std::int64_t b,
+        std::int64_t& rem) noexcept
+{
+    const std::int64_t q = a / b;
+    const std::int64_t r = a % b;
+    const std::int64_t borrow = r < 0;
+    rem = r + borrow * b;
+    return q - borrow;
+}
+
+inline std::int64_t to_days(const SQL_DATE_STRUCT& v) noexcept
+{
+    return days_from_civil(v.year, v.month, v.day);
+}
+
+inline SQL_DATE_STRUCT to_date(std::int64_t days) noexcept
+{
+    const civil c = civil_from_days(days);
+    SQL_DATE_STRUCT v;
+    v.year = static_cast<SQLSMALLINT>(c.year);
+    v.month = static_cast<SQLUSMALLINT>(c.month);
+    v.day = static_cast<SQLUSMALLINT>(c.day);
+    return v;
+}
+
+inline std::int64_t to_seconds(const SQL_TIME_STRUCT& v) noexcept
+{
+    return v.hour * 3600 + v.minute * 60 + v.second;
+}
+
+inline SQL_TIME_STRUCT to_time(std::int64_t seconds) noexcept
+{
+    std::int64_t s;
+    floor_div(seconds, 86400, s);
+    SQL_TIME_STRUCT v;
+    v.hour = static_cast<SQLUSMALLINT>(s / 3600);
+    v.minute = static_cast<SQLUSMALLINT>(s / 60 % 60);
+    v.second = static_cast<SQLUSMALLINT>(s % 60);
+    return v;
+}
+
+inline std::int64_t timestamp_seconds(const SQL_TIMESTAMP_STRUCT& v) noexcept
+{
+    return days_from_civil(v.year, v.month, v.day) * 86400
+        + v.hour * 3600 + v.minute * 60 + v.second;
+}
+
+inline std::int64_t to_micros(const SQL_TIMESTAMP_STRUCT& v) noexcept
+{
+    return timestamp_seconds(v) * 1000000 + v.fraction / 1000;
+}
+
+inline std::int64_t to_nanos(const SQL_TIMESTAMP_STRUCT& v) noexcept
+{
+    // wraps, rather than overflowing, outside its range
+    return static_cast<std::int64_t>(
+            static_cast<std::uint64_t>(timestamp_seconds(v)) * 1000000000u
+            + v.fraction);
+}
+
+// count units of 1 / per_second seconds
+inline SQL_TIMESTAMP_STRUCT to_timestamp(std::int64_t count,
+        std::int64_t per_second) noexcept
+{
+    std::int64_t sub, s;
+    const std::int64_t seconds = floor_div(count, per_second, sub);
+    const std::int64_t days = floor_div(seconds, 86400, s);
+    const civil c = civil_from_days(days);
+
+    SQL_TIMESTAMP_STRUCT v;
+    v.year = static_cast<SQLSMALLINT>(c.year);
+    v.month = static_cast<SQLUSMALLINT>(c.month);
+    v.day = static_cast<SQLUSMALLINT>(c.day);
+    v.hour = static_cast<SQLUSMALLINT>(s / 3600);
+    v.minute = static_cast<SQLUSMALLINT>(s / 60 % 60);
+    v.second = static_cast<SQLUSMALLINT>(s % 60);
+    v.fraction = static_cast<SQLUINTEGER>(sub * (1000000000 / per_second));
+    return v;
+}
+
+inline std::int64_t sign_of(const SQL_INTERVAL_STRUCT& v) noexcept
+{
+    return 1 - 2 * (v.interval_sign == SQL_TRUE);
+}
+
+inline std::int64_t to_months(const SQL_INTERVAL_STRUCT& v) noexcept
+{
+    const auto& ym = v.intval.year_month;
+    return sign_of(v) * (static_cast<std::int64_t>(ym.year) * 12 + ym.month);
+}
+
+inline std::int64_t interval_seconds(const SQL_INTERVAL_STRUCT& v) noexcept
+{
+    const auto& ds = v.intval.day_second;
+    return static_cast<std::int64_t>(ds.day) * 86400
+        + static_cast<std::int64_t>(ds.hour) * 3600
+        + static_cast<std::int64_t>(ds.minute) * 60
+        + ds.second;
+}
+
+inline std::int64_t to_micros(const SQL_INTERVAL_STRUCT& v) noexcept
+{
+    return sign_of(v)
+        * (interval_seconds(v) * 1000000 + v.intval.day_second.fraction);
+}
+
+inline std::int64_t to_nanos(const SQL_INTERVAL_STRUCT& v) noexcept
+{
+    return sign_of(v) * (interval_seconds(v) * 1000000000
+            + static_cast<std::int64_t>(v.intval.day_second.fraction) * 1000);
+}
+
+SQL_INTERVAL_STRUCT empty_interval(SQLINTERVAL type, std::int64_t count)
+    noexcept
+{
+    SQL_INTERVAL_STRUCT v;
+    std::memset(&v, 0, sizeof(v));
+    v.interval_type = type;
+    v.interval_sign = count < 0 ? SQL_TRUE : SQL_FALSE;
+    return v;
+}
+
+inline std::uint64_t magnitude(std::int64_t count) noexcept
+{
+    return count < 0 ? 0 - static_cast<std::uint64_t>(count)
+        : static_cast<std::uint64_t>(count);
+}
+
+void check_year_month(SQLINTERVAL type)
+{
+    if (type != SQL_IS_YEAR && type != SQL_IS_MONTH
+            && type != SQL_IS_YEAR_TO_MONTH)
+        throw std::invalid_argument("Not a year-month interval type!");
+}
+
+inline SQL_INTERVAL_STRUCT to_interval(std::int64_t months,
+        SQLINTERVAL type) noexcept
+{
+    SQL_INTERVAL_STRUCT v = empty_interval(type, months);
+    const std::uint64_t m = magnitude(months);
+    auto& ym = v.intval.year_month;
+    if (type == SQL_IS_MONTH) {
+        ym.month = static_cast<SQLUINTEGER>(m);
+    } else {
+        ym.year = static_cast<SQLUINTEGER>(m / 12);
+        if (type == SQL_IS_YEAR_TO_MONTH)
+            ym.month = static_cast<SQLUINTEGER>(m % 12);
+    }
+    return v;
+}
+
+// a day-time interval type's first and last fields, of day, hour,
+// minute and second
+struct field_range {
+    int first;
+    int last;
+};
+
+const std::int64_t field_seconds[] = { 86400, 3600, 60, 1 };
+
+field_range day_time_fields(SQLINTERVAL type)
+{
+    switch (type) {
+        case SQL_IS_DAY: return { 0, 0 };
+        case SQL_IS_HOUR: return { 1, 1 };
+        case SQL_IS_MINUTE: return { 2, 2 };
+        case SQL_IS_SECOND: return { 3, 3 };
+        case SQL_IS_DAY_TO_HOUR: return { 0, 1 };
+        case SQL_IS_DAY_TO_MINUTE: return { 0, 2 };
+        case SQL_IS_DAY_TO_SECOND: return { 0, 3 };
+        case SQL_IS_HOUR_TO_MINUTE: return { 1, 2 };
+        case SQL_IS_HOUR_TO_SECOND: return { 1, 3 };
+        case SQL_IS_MINUTE_TO_SECOND: return { 2, 3 };
+        default:
+            throw std::invalid_argument("Not a day-time interval type!");
+    }
+}
+
+// count units of 1 / per_second seconds
+inline SQL_INTERVAL_STRUCT to_interval(std::int64_t count,
+        std::int64_t per_second, SQLINTERVAL type, field_range fields)
+    noexcept
+{
+    SQL_INTERVAL_STRUCT v = empty_interval(type, count);
+    const std::uint64_t m = magnitude(count);
+    std::uint64_t rest = m / per_second;
+
+    auto& ds = v.intval.day_second;
+    SQLUINTEGER* values[] = { &ds.day, &ds.hour, &ds.minute, &ds.second };
+    for (int f = fields.first; f <= fields.last; ++f) {
+        *values[f] = static_cast<SQLUINTEGER>(rest / field_seconds[f]);
+        rest %= field_seconds[f];
+    }
+
+    if (fields.last == 3)
+        ds.fraction = static_cast<SQLUINTEGER>(
+                m % per_second / (per_second / 1000000));
+
+    return v;
+}
+
+}
+
+std::int64_t date_to_days(const SQL_DATE_STRUCT& v) noexcept
+{
+    return to_days(v);
+}
+
+SQL_DATE_STRUCT days_to_date(std::int64_t days) noexcept
+{
+    return to_date(days);
+}
+
+std::int64_t time_to_seconds(const SQL_TIME_STRUCT& v) noexcept
+{
+    return to_seconds(v);
+}
+
+SQL_TIME_STRUCT seconds_to_time(std::int64_t seconds) noexcept
+{
+    return to_time(seconds);
+}
+
+std::int64_t timestamp_to_micros(const SQL_TIMESTAMP_STRUCT& v) noexcept
+{
+    return to_micros(v);
+}
+
+std::int64_t timestamp_to_nanos(const SQL_TIMESTAMP_STRUCT& v) noexcept
+{
+    return to_nanos(v);
+}
+
+SQL_TIMESTAMP_STRUCT micros_to_timestamp(std::int64_t micros) noexcept
+{
+    return to_timestamp(micros, 1000000);
+}
+
+SQL_TIMESTAMP_STRUCT nanos_to_timestamp(std::int64_t nanos) noexcept
+{
+    return to_timestamp(nanos, 1000000000);
+}
+
+std::int64_t interval_to_months(const SQL_INTERVAL_STRUCT& v) noexcept
+{
+    return to_months(v);
+}
+
+std::int64_t interval_to_micros(const SQL_INTERVAL_STRUCT& v) noexcept
+{
+    return to_micros(v);
+}
+
+std::int64_t interval_to_nanos(const SQL_INTERVAL_STRUCT& v) noexcept
+{
+    return to_nanos(v);
+}
+
+SQL_INTERVAL_STRUCT months_to_interval(std::int64_t months,
+        SQLINTERVAL type)
+{
+    check_year_month(type);
+    return to_interval(months, type);
+}
+
+SQL_INTERVAL_STRUCT micros_to_interval(std::int64_t micros,
+        SQLINTERVAL type)
+{
+    return to_interval(micros, 1000000, type, day_time_fields(type));
+}
+
+SQL_INTERVAL_STRUCT nanos_to_interval(std::int64_t nanos, SQLINTERVAL type)
+{
+    return to_interval(nanos, 1000000000, type, day_time_fields(type));
+}
+
+void date_to_days(const SQL_DATE_STRUCT* v, std::size_t n,
+        std::int64_t* out) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_days(v[i]);
+}
+
+void days_to_date(const std::int64_t* days, std::size_t n,
+        SQL_DATE_STRUCT* out) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_date(days[i]);
+}
+
+void time_to_seconds(const SQL_TIME_STRUCT* v, std::size_t n,
+        std::int64_t* out) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_seconds(v[i]);
+}
+
+void seconds_to_time(const std::int64_t* seconds, std::size_t n,
+        SQL_TIME_STRUCT* out) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_time(seconds[i]);
+}
+
+void timestamp_to_micros(const SQL_TIMESTAMP_STRUCT* v, std::size_t n,
+        std::int64_t* out) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_micros(v[i]);
+}
+
+void timestamp_to_nanos(const SQL_TIMESTAMP_STRUCT* v, std::size_t n,
+        std::int64_t* out) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_nanos(v[i]);
+}
+
+void micros_to_timestamp(const std::int64_t* micros, std::size_t n,
+        SQL_TIMESTAMP_STRUCT* out) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_timestamp(micros[i], 1000000);
+}
+
+void nanos_to_timestamp(const std::int64_t* nanos, std::size_t n,
+        SQL_TIMESTAMP_STRUCT* out) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_timestamp(nanos[i], 1000000000);
+}
+
+void interval_to_months(const SQL_INTERVAL_STRUCT* v, std::size_t n,
+        std::int64_t* out) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_months(v[i]);
+}
+
+void interval_to_micros(const SQL_INTERVAL_STRUCT* v, std::size_t n,
+        std::int64_t* out) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_micros(v[i]);
+}
+
+void interval_to_nanos(const SQL_INTERVAL_STRUCT* v, std::size_t n,
+        std::int64_t* out) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_nanos(v[i]);
+}
+
+void months_to_interval(const std::int64_t* months, std::size_t n,
+        SQLINTERVAL type, SQL_INTERVAL_STRUCT* out)
+{
+    check_year_month(type);
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_interval(months[i], type);
+}
+
+void micros_to_interval(const std::int64_t* micros, std::size_t n,
+        SQLINTERVAL type, SQL_INTERVAL_STRUCT* out)
+{
+    const field_range fields = day_time_fields(type);
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_interval(micros[i], 1000000, type, fields);
+}
+
+void nanos_to_interval(const std::int64_t* nanos, std::size_t n,
+        SQLINTERVAL type, SQL_INTERVAL_STRUCT* out)
+{
+    const field_range fields = day_time_fields(type);
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = to_interval(nanos[i], 1000000000, type, fields);
+}
+
+}
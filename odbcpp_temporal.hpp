@@ -0,0 +1,104 @@
+#ifndef ODBCPP_TEMPORAL_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "odbcpp.hpp"
+
+namespace odbcpp {
+
+// date, time, timestamp and interval structs to and from integer counts
+// dates and timestamps count from 1970-01-01 00:00:00 in the proleptic
+// Gregorian calendar, with no time zone (the values are taken as UTC);
+// times count from midnight
+// timestamp fractions are nanoseconds; interval fractions are taken to
+// be microseconds (the default interval seconds precision)
+// conversions to smaller units truncate toward zero; nanosecond
+// timestamps cover the years 1677 to 2262
+
+std::int64_t date_to_days(const SQL_DATE_STRUCT& v) noexcept;
+
+SQL_DATE_STRUCT days_to_date(std::int64_t days) noexcept;
+
+std::int64_t time_to_seconds(const SQL_TIME_STRUCT& v) noexcept;
+
+// seconds is taken modulo a day
+SQL_TIME_STRUCT seconds_to_time(std::int64_t seconds) noexcept;
+
+std::int64_t timestamp_to_micros(const SQL_TIMESTAMP_STRUCT& v) noexcept;
+
+std::int64_t timestamp_to_nanos(const SQL_TIMESTAMP_STRUCT& v) noexcept;
+
+SQL_TIMESTAMP_STRUCT micros_to_timestamp(std::int64_t micros) noexcept;
+
+SQL_TIMESTAMP_STRUCT nanos_to_timestamp(std::int64_t nanos) noexcept;
+
+// year-month intervals (year, month, year_to_month) as signed months
+std::int64_t interval_to_months(const SQL_INTERVAL_STRUCT& v) noexcept;
+
+// day-time intervals (the rest) as signed durations
+std::int64_t interval_to_micros(const SQL_INTERVAL_STRUCT& v) noexcept;
+
+std::int64_t interval_to_nanos(const SQL_INTERVAL_STRUCT& v) noexcept;
+
+// the interval's leading field takes whatever is above it, and fields
+// after its last are dropped (e.g. 90 minutes as SQL_IS_HOUR is 1);
+// types of the wrong kind throw std::invalid_argument
+SQL_INTERVAL_STRUCT months_to_interval(std::int64_t months,
+        SQLINTERVAL type = SQL_IS_YEAR_TO_MONTH);
+
+SQL_INTERVAL_STRUCT micros_to_interval(std::int64_t micros,
+        SQLINTERVAL type = SQL_IS_DAY_TO_SECOND);
+
+SQL_INTERVAL_STRUCT nanos_to_interval(std::int64_t nanos,
+        SQLINTERVAL type = SQL_IS_DAY_TO_SECOND);
+
+// n values at a time, e.g. a column's values() (whose NULLs are zeroed,
+// so convert to something meaningless), or a bulk_writer's parameters
+
+void date_to_days(const SQL_DATE_STRUCT* v, std::size_t n,
+        std::int64_t* out) noexcept;
+
+void days_to_date(const std::int64_t* days, std::size_t n,
+        SQL_DATE_STRUCT* out) noexcept;
+
+void time_to_seconds(const SQL_TIME_STRUCT* v, std::size_t n,
+        std::int64_t* out) noexcept;
+
+void seconds_to_time(const std::int64_t* seconds, std::size_t n,
+        SQL_TIME_STRUCT* out) noexcept;
+
+void timestamp_to_micros(const SQL_TIMESTAMP_STRUCT* v, std::size_t n,
+        std::int64_t* out) noexcept;
+
+void timestamp_to_nanos(const SQL_TIMESTAMP_STRUCT* v, std::size_t n,
+        std::int64_t* out) noexcept;
+
+void micros_to_timestamp(const std::int64_t* micros, std::size_t n,
+        SQL_TIMESTAMP_STRUCT* out) noexcept;
+
+void nanos_to_timestamp(const std::int64_t* nanos, std::size_t n,
+        SQL_TIMESTAMP_STRUCT* out) noexcept;
+
+void interval_to_months(const SQL_INTERVAL_STRUCT* v, std::size_t n,
+        std::int64_t* out) noexcept;
+
+void interval_to_micros(const SQL_INTERVAL_STRUCT* v, std::size_t n,
+        std::int64_t* out) noexcept;
+
+void interval_to_nanos(const SQL_INTERVAL_STRUCT* v, std::size_t n,
+        std::int64_t* out) noexcept;
+
+void months_to_interval(const std::int64_t* months, std::size_t n,
+        SQLINTERVAL type, SQL_INTERVAL_STRUCT* out);
+
+void micros_to_interval(const std::int64_t* micros, std::size_t n,
+        SQLINTERVAL type, SQL_INTERVAL_STRUCT* out);
+
+void nanos_to_interval(const std::int64_t* nanos, std::size_t n,
+        SQLINTERVAL type, SQL_INTERVAL_STRUCT* out);
+
+}
+
+#define ODBCPP_TEMPORAL_HPP
+#endif
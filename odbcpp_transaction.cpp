@@ -0,0 +1,104 @@
+#include "odbcpp_transaction.hpp"
+
+#include <stdexcept>
+
+namespace odbcpp {
+
+transaction::transaction(connection& conn)
+    : conn_(conn), done_(false)
+{
+    conn_.begin();
+}
+
+transaction::~transaction() noexcept
+{
+    if (done_ || !conn_.in_transaction())
+        return;
+
+    try {
+        conn_.rollback();
+    } catch (...) {
+    }
+}
+
+void transaction::commit()
+{
+    if (done_)
+        throw std::runtime_error("Transaction already ended!");
+
+    // a failed commit leaves the transaction to be rolled back
+    conn_.commit();
+    done_ = true;
+}
+
+void transaction::rollback()
+{
+    if (done_)
+        throw std::runtime_error("Transaction already ended!");
+
+    done_ = true;
+    conn_.rollback();
+}
+
+commit_batcher::commit_batcher(connection& conn, std::size_t rows,
+        std::chrono::milliseconds interval)
+    : conn_(conn), rows_(rows), interval_(interval), pending_(0),
+    commits_(0), last_commit_(), done_(false)
+{
+    conn_.begin();
+    last_commit_ = clock::now();
+}
+
+commit_batcher::~commit_batcher() noexcept
+{
+    if (done_ || !conn_.in_transaction())
+        return;
+
+    try {
+        conn_.rollback();
+    } catch (...) {
+    }
+}
+
+bool commit_batcher::add(std::size_t rows)
+{
+    if (done_)
+        throw std::runtime_error("Commit batcher already finished!");
+
+    pending_ += rows;
+
+    bool due = rows_ && pending_ >= rows_;
+    // the clock is only read when there's an interval to keep
+    if (!due && interval_.count() > 0 && pending_)
+        due = clock::now() - last_commit_ >= interval_;
+
+    if (!due)
+        return false;
+
+    flush();
+    return true;
+}
+
+void commit_batcher::flush()
+{
+    if (done_)
+        throw std::runtime_error("Commit batcher already finished!");
+
+    conn_.commit(true);
+    ++commits_;
+    pending_ = 0;
+    last_commit_ = clock::now();
+}
+
+void commit_batcher::finish()
+{
+    if (done_)
+        throw std::runtime_error("Commit batcher already finished!");
+
+    conn_.commit();
+    ++commits_;
+    pending_ = 0;
+    done_ = true;
+}
+
+}
@@ -0,0 +1,78 @@
+#ifndef ODBCPP_TRANSACTION_HPP
+
+#include <chrono>
+#include <cstddef>
+
+#include "odbcpp.hpp"
+
+namespace odbcpp {
+
+// a transaction on conn for the guard's lifetime, rolled back on
+// destruction unless committed (or rolled back) before
+class transaction {
+    public:
+        explicit transaction(connection& conn);
+
+        transaction(const transaction&) = delete;
+
+        transaction& operator=(const transaction&) = delete;
+
+        ~transaction() noexcept;
+
+        void commit();
+
+        void rollback();
+
+    private:
+        connection& conn_;
+        bool done_;
+};
+
+// one transaction for a long-running writer, committed every rows
+// rows or every interval (zero for no limit), whichever comes first;
+// work since the last commit is rolled back on destruction unless
+// finish()ed
+// rows are counted as they're added, so with a bulk_writer a commit
+// may come before its buffered rows are sent; they go in the next
+class commit_batcher {
+    public:
+        commit_batcher(connection& conn, std::size_t rows,
+                std::chrono::milliseconds interval =
+                    std::chrono::milliseconds::zero());
+
+        commit_batcher(const commit_batcher&) = delete;
+
+        commit_batcher& operator=(const commit_batcher&) = delete;
+
+        ~commit_batcher() noexcept;
+
+        // count rows written; returns true if that made a commit due
+        // (and it was made)
+        bool add(std::size_t rows = 1);
+
+        // commit whatever is pending now
+        void flush();
+
+        // commit the rest, and end the transaction
+        void finish();
+
+        std::size_t pending() const noexcept { return pending_; }
+
+        std::size_t commits() const noexcept { return commits_; }
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        connection& conn_;
+        std::size_t rows_;
+        std::chrono::milliseconds interval_;
+        std::size_t pending_;
+        std::size_t commits_;
+        clock::time_point last_commit_;
+        bool done_;
+};
+
+}
+
+#define ODBCPP_TRANSACTION_HPP
+#endif
@@ -0,0 +1,165 @@
+#include "odbcpp_typed.hpp"
+
+namespace odbcpp {
+
+namespace detail {
+
+namespace {
+
+enum class type_group : char {
+    number,
+    date,
+    time,
+    timestamp,
+    guid,
+    interval,
+    character,
+    binary
+};
+
+type_group group_of(data_type type)
+{
+    switch (odbc_c_tag_from_type(type)) {
+        case SQL_C_TYPE_DATE:
+            return type_group::date;
+
+        case SQL_C_TYPE_TIME:
+            return type_group::time;
+
+        case SQL_C_TYPE_TIMESTAMP:
+            return type_group::timestamp;
+
+        case SQL_C_GUID:
+            return type_group::guid;
+
+        case SQL_C_CHAR:
+        case SQL_C_WCHAR:
+            return type_group::character;
+
+        case SQL_C_BINARY:
+            return type_group::binary;
+
+        case SQL_C_SHORT:
+        case SQL_C_LONG:
+        case SQL_C_SBIGINT:
+        case SQL_C_TINYINT:
+        case SQL_C_BIT:
+        case SQL_C_FLOAT:
+        case SQL_C_DOUBLE:
+        case SQL_C_NUMERIC:
+            return type_group::number;
+
+        default:
+            return type_group::interval;
+    }
+}
+
+// conversions the driver can be relied on for
+bool bindable(data_type member, data_type field)
+{
+    auto m = group_of(member), f = group_of(field);
+    switch (m) {
+        case type_group::character:
+            return true;
+
+        case type_group::date:
+        case type_group::time:
+            return f == m || f == type_group::timestamp;
+
+        case type_group::timestamp:
+            return f == m || f == type_group::date;
+
+        default:
+            return f == m;
+    }
+}
+
+}
+
+typed_cursor::typed_cursor(connection& conn, std::size_t row_size,
+        std::size_t block_size)
+    : stmt_(conn.native_handle()), fields_(), block_size_(block_size),
+    rows_fetched_(0), row_(0)
+{
+    if (!conn)
+        throw std::runtime_error("No active connection for query!");
+
+    const SQLULEN requested = block_size_;
+    set_block_cursor(stmt_, row_size, block_size_, &rows_fetched_);
+
+    if (block_size_ == 0 || block_size_ > requested)
+        throw std::runtime_error("Unsupported rowset size!");
+}
+
+void typed_cursor::execute(const string& statement, unsigned char* rows,
+        const std::vector<member_binding>& members)
+{
+    SQLFreeStmt(stmt_, SQL_CLOSE);
+    SQLFreeStmt(stmt_, SQL_UNBIND);
+    fields_.clear();
+    rows_fetched_ = 0;
+    row_ = 0;
+
+    auto ret = SQLExecDirect(stmt_, const_cast<SQLCHAR*>(statement.c_str()),
+            SQL_NTS);
+    if (!SQL_SUCCEEDED(ret) && ret != SQL_NO_DATA)
+        throw std::runtime_error(
+                std::string("Unable to execute query!")
+                + " : " + stmt_.error_message());
+
+    auto fields = describe_fields(stmt_);
+    if (fields.size() != members.size())
+        throw std::runtime_error(
+                std::string("Row type doesn't match result!")
+                + " : " + std::to_string(fields.size()) + " fields for "
+                + std::to_string(members.size()) + " members");
+
+    for (std::size_t i = 0; i < members.size(); ++i) {
+        const auto& m = members[i];
+        const auto& f = fields[i];
+        if (!bindable(m.type, f.type))
+            throw std::runtime_error(
+                    std::string("Row type doesn't match result!")
+                    + " : " + f.name + " is " + type_name(f.type)
+                    + ", not " + type_name(m.type));
+
+        // the member's C type is any interval; the field says which
+        auto c_type = group_of(m.type) == type_group::interval
+            ? odbc_c_tag_from_type(f.type) : odbc_c_tag_from_type(m.type);
+
+        SQLLEN* indicator = m.indicator_offset < 0 ? nullptr
+            : reinterpret_cast<SQLLEN*>(rows + m.indicator_offset);
+        ret = SQLBindCol(stmt_, i + 1, c_type, rows + m.value_offset,
+                m.length, indicator);
+        if (!SQL_SUCCEEDED(ret))
+            throw std::runtime_error(
+                    std::string("Unable to bind column!")
+                    + " : " + stmt_.error_message());
+
+        if (c_type == SQL_C_NUMERIC)
+            describe_numeric(stmt_, i, f, rows + m.value_offset);
+    }
+
+    fields_ = std::move(fields);
+    fetch();
+}
+
+void typed_cursor::fetch()
+{
+    row_ = 0;
+    rows_fetched_ = 0;
+
+    auto ret = SQLFetch(stmt_);
+    if (ret == SQL_NO_DATA)
+        return;
+
+    // SQL_SUCCESS_WITH_INFO covers truncation into fixed_string members
+    if (!SQL_SUCCEEDED(ret))
+        throw std::runtime_error(
+                std::string("Unable to fetch row!")
+                + " : " + stmt_.error_message());
+}
+
+}
+
+}
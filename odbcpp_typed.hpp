@@ -0,0 +1,324 @@
+#ifndef ODBCPP_TYPED_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "odbcpp.hpp"
+
+namespace odbcpp {
+
+// row members for character and binary data, bound in place
+// values longer than N are truncated; NULLs have is_null() set
+
+template<std::size_t N>
+struct fixed_string {
+    SQLLEN indicator;
+    SQLCHAR data[N + 1];
+
+    bool is_null() const noexcept { return indicator == SQL_NULL_DATA; }
+
+    // in characters
+    std::size_t size() const noexcept
+    {
+        return indicator < 0 ? 0
+            : std::min<std::size_t>(indicator, N);
+    }
+
+    std::string str() const
+    {
+        return std::string(reinterpret_cast<const char*>(data), size());
+    }
+};
+
+template<std::size_t N>
+struct fixed_wstring {
+    SQLLEN indicator;
+    SQLWCHAR data[N + 1];
+
+    bool is_null() const noexcept { return indicator == SQL_NULL_DATA; }
+
+    // in characters
+    std::size_t size() const noexcept
+    {
+        return indicator < 0 ? 0
+            : std::min<std::size_t>(indicator / sizeof(SQLWCHAR), N);
+    }
+};
+
+template<std::size_t N>
+struct fixed_binary {
+    SQLLEN indicator;
+    SQLCHAR data[N];
+
+    bool is_null() const noexcept { return indicator == SQL_NULL_DATA; }
+
+    std::size_t size() const noexcept
+    {
+        return indicator < 0 ? 0
+            : std::min<std::size_t>(indicator, N);
+    }
+};
+
+// a fixed-size member which may be NULL; fetching a NULL into a plain
+// member fails (the driver has nowhere to report it)
+template<class T>
+struct nullable {
+    SQLLEN indicator;
+    T value;
+
+    bool is_null() const noexcept { return indicator == SQL_NULL_DATA; }
+
+    explicit operator bool() const noexcept { return !is_null(); }
+
+    const T& operator*() const noexcept { return value; }
+};
+
+// maps a row type's members, in field order, by calling f on each;
+// specialize for structs:
+//   template<> struct row_mapping<employee> {
+//       template<class F> static void for_each(employee& r, F& f)
+//       {
+//           f(r.id); f(r.name); f(r.hired);
+//       }
+//   };
+template<class Row>
+struct row_mapping;
+
+namespace detail {
+
+template<std::size_t... I>
+struct index_sequence {};
+
+template<std::size_t N, std::size_t... I>
+struct make_index_sequence_impl : make_index_sequence_impl<N - 1, N - 1, I...> {};
+
+template<std::size_t... I>
+struct make_index_sequence_impl<0, I...> {
+    using type = index_sequence<I...>;
+};
+
+template<std::size_t N>
+using make_index_sequence = typename make_index_sequence_impl<N>::type;
+
+template<class Tuple, class F, std::size_t... I>
+void for_each_element(Tuple& t, F& f, index_sequence<I...>)
+{
+    int expand[] = { 0, (f(std::get<I>(t)), 0)... };
+    static_cast<void>(expand);
+}
+
+static const int nonpointer_type_count = 0
+#define FOR_EACH_DATA_TYPE(tag, type, c_tag, sql_tag) + 1
+#include "nonpointer_types.def"
+#undef FOR_EACH_DATA_TYPE
+    ;
+
+// the first fixed-size data_type whose C type is T
+// (so SQLDOUBLE is double_float, SQL_INTERVAL_STRUCT interval_year)
+template<class T, int I = 0>
+struct member_type : std::conditional<
+    std::is_same<
+        T,
+        typename data_type_traits<static_cast<data_type>(I)>::odbc_type
+    >::value,
+    std::integral_constant<data_type, static_cast<data_type>(I)>,
+    member_type<T, I + 1>
+>::type {};
+
+template<class T>
+struct member_type<T, nonpointer_type_count> {
+    static_assert(sizeof(T) == 0,
+            "Row members must be ODBC C types, nullable<>, "
+            "fixed_string<>, fixed_wstring<> or fixed_binary<>!");
+};
+
+// where one row member lives, relative to the start of the row
+struct member_binding {
+    data_type type;
+    std::size_t value_offset;
+    // -1 without an indicator
+    std::ptrdiff_t indicator_offset;
+    SQLLEN length;
+};
+
+inline std::size_t offset_in(const void* member, const void* row) noexcept
+{
+    return static_cast<const unsigned char*>(member)
+        - static_cast<const unsigned char*>(row);
+}
+
+template<class T>
+struct member_traits {
+    static member_binding describe(const T& m, const void* row)
+    {
+        return { member_type<T>::value, offset_in(&m, row), -1, sizeof(T) };
+    }
+};
+
+template<class T>
+struct member_traits<nullable<T>> {
+    static member_binding describe(const nullable<T>& m, const void* row)
+    {
+        return {
+            member_type<T>::value,
+            offset_in(&m.value, row),
+            static_cast<std::ptrdiff_t>(offset_in(&m.indicator, row)),
+            sizeof(T)
+        };
+    }
+};
+
+template<std::size_t N>
+struct member_traits<fixed_string<N>> {
+    static member_binding describe(const fixed_string<N>& m, const void* row)
+    {
+        return {
+            data_type::varchar,
+            offset_in(m.data, row),
+            static_cast<std::ptrdiff_t>(offset_in(&m.indicator, row)),
+            sizeof(m.data)
+        };
+    }
+};
+
+template<std::size_t N>
+struct member_traits<fixed_wstring<N>> {
+    static member_binding describe(const fixed_wstring<N>& m, const void* row)
+    {
+        return {
+            data_type::wide_varchar,
+            offset_in(m.data, row),
+            static_cast<std::ptrdiff_t>(offset_in(&m.indicator, row)),
+            sizeof(m.data)
+        };
+    }
+};
+
+template<std::size_t N>
+struct member_traits<fixed_binary<N>> {
+    static member_binding describe(const fixed_binary<N>& m, const void* row)
+    {
+        return {
+            data_type::varbinary,
+            offset_in(m.data, row),
+            static_cast<std::ptrdiff_t>(offset_in(&m.indicator, row)),
+            sizeof(m.data)
+        };
+    }
+};
+
+struct member_collector {
+    const void* row;
+    std::vector<member_binding>& members;
+
+    template<class T>
+    void operator()(const T& m)
+    {
+        members.push_back(member_traits<T>::describe(m, row));
+    }
+};
+
+// the untyped part of typed_query: a statement fetching blocks of rows
+// with row-wise binding (SQL_ATTR_ROW_BIND_TYPE)
+class typed_cursor {
+    public:
+        typed_cursor(const typed_cursor&) = delete;
+
+        typed_cursor& operator=(const typed_cursor&) = delete;
+
+        const std::vector<field>& fields() const noexcept { return fields_; }
+
+    protected:
+        handle<handle_type::statement> stmt_;
+        std::vector<field> fields_;
+        SQLULEN block_size_;
+        SQLULEN rows_fetched_;
+        SQLULEN row_;
+
+        typed_cursor(connection& conn, std::size_t row_size,
+                std::size_t block_size);
+
+        ~typed_cursor() noexcept = default;
+
+        // execute, check the result against members (the row type's
+        // layout) and bind it to rows; then fetch the first block
+        void execute(const string& statement, unsigned char* rows,
+                const std::vector<member_binding>& members);
+
+        void fetch();
+};
+
+}
+
+// a query whose rows are bound straight into an array of Row, which
+// is a std::tuple or a struct with a row_mapping, e.g.
+//   typed_query<std::tuple<SQLINTEGER, fixed_string<40>,
+//       nullable<SQL_TIMESTAMP_STRUCT>>>
+// members are checked against the result's fields once, at execute;
+// after that rows are read without any type dispatch
+template<class Row>
+class typed_query : public detail::typed_cursor {
+    public:
+        static const std::size_t default_fetch_size = 256;
+
+        explicit typed_query(connection& conn,
+                std::size_t fetch_size = default_fetch_size)
+            : detail::typed_cursor(conn, sizeof(Row),
+                    fetch_size ? fetch_size : 1),
+            rows_(new Row[block_size_]()), members_()
+        {
+            detail::member_collector collect { &rows_[0], members_ };
+            row_mapping<Row>::for_each(rows_[0], collect);
+        }
+
+        void execute(const string& statement)
+        {
+            detail::typed_cursor::execute(statement,
+                    reinterpret_cast<unsigned char*>(rows_.get()), members_);
+        }
+
+        template<class StrType>
+        void execute(const StrType& statement)
+        {
+            execute(make_string(statement));
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return row_ < rows_fetched_;
+        }
+
+        const Row& operator*() const noexcept { return rows_[row_]; }
+
+        const Row* operator->() const noexcept { return &rows_[row_]; }
+
+        void advance()
+        {
+            if (++row_ == rows_fetched_)
+                fetch();
+        }
+
+    private:
+        std::unique_ptr<Row[]> rows_;
+        std::vector<detail::member_binding> members_;
+};
+
+template<class... T>
+struct row_mapping<std::tuple<T...>> {
+    template<class F>
+    static void for_each(std::tuple<T...>& row, F& f)
+    {
+        detail::for_each_element(row, f,
+                detail::make_index_sequence<sizeof...(T)>());
+    }
+};
+
+}
+
+#define ODBCPP_TYPED_HPP
+#endif
@@ -0,0 +1,220 @@
+#include "odbcpp_unicode.hpp"
+
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ODBCPP_UNICODE_AVX2
+#define ODBCPP_UNICODE_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ODBCPP_UNICODE_SSE2
+#endif
+
+namespace odbcpp {
+
+namespace {
+
+// the code point at s[i] (with s[i + 1], for a surrogate pair);
+// moves i past it
+inline std::uint32_t decode(const SQLWCHAR* s, std::size_t len,
+        std::size_t& i) noexcept
+{
+    std::uint32_t cp = static_cast<std::uint32_t>(s[i++]);
+    if (sizeof(SQLWCHAR) == 2) {
+        cp &= 0xffff;
+        if (cp >= 0xd800 && cp < 0xdc00 && i < len) {
+            std::uint32_t low = static_cast<std::uint32_t>(s[i]) & 0xffff;
+            if (low >= 0xdc00 && low < 0xe000) {
+                ++i;
+                return 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+            }
+        }
+    }
+
+    if ((cp >= 0xd800 && cp < 0xe000) || cp > 0x10ffff)
+        return 0xfffd;
+
+    return cp;
+}
+
+inline std::size_t encoded_size(std::uint32_t cp) noexcept
+{
+    return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+}
+
+inline char* encode(std::uint32_t cp, char* p) noexcept
+{
+    if (cp < 0x80) {
+        *p++ = static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        *p++ = static_cast<char>(0xc0 | (cp >> 6));
+        *p++ = static_cast<char>(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+        *p++ = static_cast<char>(0xe0 | (cp >> 12));
+        *p++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        *p++ = static_cast<char>(0x80 | (cp & 0x3f));
+    } else {
+        *p++ = static_cast<char>(0xf0 | (cp >> 18));
+        *p++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+        *p++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        *p++ = static_cast<char>(0x80 | (cp & 0x3f));
+    }
+
+    return p;
+}
+
+// code points up to the end of a block, one at a time
+// (a surrogate pair across its end takes a unit more)
+inline char* encode_block(const SQLWCHAR* s, std::size_t len,
+        std::size_t& i, std::size_t end, char* out) noexcept
+{
+    while (i < end)
+        out = encode(decode(s, len, i), out);
+    return out;
+}
+
+#ifdef ODBCPP_UNICODE_SSE2
+
+// 8 UTF-16 units, if they're all ASCII or all two-byte characters;
+// returns nullptr otherwise
+inline char* block_8(const SQLWCHAR* s, char* out) noexcept
+{
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+    const __m128i zero = _mm_setzero_si128();
+
+    const int ascii = _mm_movemask_epi8(_mm_cmpeq_epi16(
+                _mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xff80))),
+                zero));
+    if (ascii == 0xffff) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out),
+                _mm_packus_epi16(v, v));
+        return out + 8;
+    }
+
+    const int below_800 = _mm_movemask_epi8(_mm_cmpeq_epi16(
+                _mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xf800))),
+                zero));
+    if (ascii == 0 && below_800 == 0xffff) {
+        // 110xxxxx 10xxxxxx, lead byte first
+        const __m128i lead = _mm_or_si128(_mm_srli_epi16(v, 6),
+                _mm_set1_epi16(0xc0));
+        const __m128i trail = _mm_or_si128(
+                _mm_and_si128(v, _mm_set1_epi16(0x3f)),
+                _mm_set1_epi16(0x80));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                _mm_or_si128(lead, _mm_slli_epi16(trail, 8)));
+        return out + 16;
+    }
+
+    return nullptr;
+}
+
+#endif
+
+#ifdef ODBCPP_UNICODE_AVX2
+
+// as block_8, for 16 units
+inline char* block_16(const SQLWCHAR* s, char* out) noexcept
+{
+    const __m256i v = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(s));
+    const __m256i zero = _mm256_setzero_si256();
+
+    const int ascii = _mm256_movemask_epi8(_mm256_cmpeq_epi16(
+                _mm256_and_si256(v,
+                    _mm256_set1_epi16(static_cast<short>(0xff80))),
+                zero));
+    if (ascii == -1) {
+        // packing works within 128-bit lanes; gather the lanes' halves
+        const __m256i packed = _mm256_permute4x64_epi64(
+                _mm256_packus_epi16(v, v), 0xd8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                _mm256_castsi256_si128(packed));
+        return out + 16;
+    }
+
+    const int below_800 = _mm256_movemask_epi8(_mm256_cmpeq_epi16(
+                _mm256_and_si256(v,
+                    _mm256_set1_epi16(static_cast<short>(0xf800))),
+                zero));
+    if (ascii == 0 && below_800 == -1) {
+        const __m256i lead = _mm256_or_si256(_mm256_srli_epi16(v, 6),
+                _mm256_set1_epi16(0xc0));
+        const __m256i trail = _mm256_or_si256(
+                _mm256_and_si256(v, _mm256_set1_epi16(0x3f)),
+                _mm256_set1_epi16(0x80));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                _mm256_or_si256(lead, _mm256_slli_epi16(trail, 8)));
+        return out + 32;
+    }
+
+    return nullptr;
+}
+
+#endif
+
+}
+
+std::size_t utf8_size(const SQLWCHAR* s, std::size_t len) noexcept
+{
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < len; )
+        size += encoded_size(decode(s, len, i));
+    return size;
+}
+
+char* to_utf8(const SQLWCHAR* s, std::size_t len, char* out) noexcept
+{
+    std::size_t i = 0;
+
+    if (sizeof(SQLWCHAR) == 2) {
+#ifdef ODBCPP_UNICODE_AVX2
+        while (i + 16 <= len) {
+            if (char* p = block_16(s + i, out)) {
+                out = p;
+                i += 16;
+            } else {
+                out = encode_block(s, len, i, i + 16, out);
+            }
+        }
+#endif
+
+#ifdef ODBCPP_UNICODE_SSE2
+        while (i + 8 <= len) {
+            if (char* p = block_8(s + i, out)) {
+                out = p;
+                i += 8;
+            } else {
+                out = encode_block(s, len, i, i + 8, out);
+            }
+        }
+#endif
+    }
+
+    return encode_block(s, len, i, len, out);
+}
+
+std::string to_utf8(const SQLWCHAR* s, std::size_t len)
+{
+    std::string text(utf8_capacity(len), '\0');
+    char* begin = &text[0];
+    text.resize(to_utf8(s, len, begin) - begin);
+    return text;
+}
+
+wchar_t* to_wchar(const SQLWCHAR* s, std::size_t len, wchar_t* out) noexcept
+{
+    if (sizeof(wchar_t) < 4) {
+        for (std::size_t i = 0; i < len; ++i)
+            *out++ = static_cast<wchar_t>(s[i]);
+        return out;
+    }
+
+    for (std::size_t i = 0; i < len; )
+        *out++ = static_cast<wchar_t>(decode(s, len, i));
+    return out;
+}
+
+}
@@ -0,0 +1,39 @@
+#ifndef ODBCPP_UNICODE_HPP
+
+#include <cstddef>
+#include <string>
+
+#include "odbcpp.hpp"
+
+namespace odbcpp {
+
+// wide (SQLWCHAR) text is UTF-16, or UTF-32 where SQLWCHAR is 4 bytes;
+// unpaired surrogates convert to U+FFFD
+
+// enough room for the UTF-8 of len code units
+constexpr std::size_t utf8_capacity(std::size_t len) noexcept
+{
+    // a surrogate pair (two units) is four bytes of UTF-8
+    return len * (sizeof(SQLWCHAR) == 2 ? 3 : 4);
+}
+
+// the exact length of the UTF-8 of [s, s + len)
+std::size_t utf8_size(const SQLWCHAR* s, std::size_t len) noexcept;
+
+// write the UTF-8 of [s, s + len) to out, which must have room for
+// utf8_capacity(len) bytes; returns the end of the text
+// runs of ASCII, and of two-byte characters (U+0080 to U+07FF), are
+// converted 16 units at a time when built for AVX2, and 8 for SSE2
+char* to_utf8(const SQLWCHAR* s, std::size_t len, char* out) noexcept;
+
+std::string to_utf8(const SQLWCHAR* s, std::size_t len);
+
+// the text as wchar_t, which out must have room for len of; surrogate
+// pairs are combined where wchar_t is 4 bytes, and units copied as
+// they are otherwise; returns the end of the text
+wchar_t* to_wchar(const SQLWCHAR* s, std::size_t len, wchar_t* out) noexcept;
+
+}
+
+#define ODBCPP_UNICODE_HPP
+#endif
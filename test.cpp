@@ -21,8 +21,9 @@ int main(int argc, char *argv[])
     connection conn(argv[1]);
 
     while (std::cin.getline(line, 1024)) {
-        auto q = conn.make_query();
-        q.execute(line);
+        // repeated lines reuse the statement from the connection's cache
+        auto q = conn.prepare(line);
+        q.execute();
 
         if (q) {
             for (unsigned i = 0; i < q.fields().size(); ++i)
@@ -33,7 +34,7 @@ int main(int argc, char *argv[])
 
         while (q) {
             for (unsigned i = 0; i < q.fields().size(); ++i)
-                std::cout << (i ? "\t" : "") << *(q.get(i));
+                std::cout << (i ? "\t" : "") << q.at(i);
             std::cout << '\n';
             q.advance();
         }